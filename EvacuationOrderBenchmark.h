@@ -0,0 +1,94 @@
+#pragma once
+
+#define _COMPILE_EVACUATION_ORDER_BENCHMARK 0
+
+#if _COMPILE_EVACUATION_ORDER_BENCHMARK
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include "GCPtr.h"
+
+// 转移顺序对遍历局部性的影响：构造一条按随机顺序链接的链表并使其所在region充满碎片，触发转移后遍历链表
+// 分别以enableDepthFirstEvacuation为true和false运行，对比链表相邻结点在内存中相邻的比例及遍历耗时
+class EvacuationOrderBenchmark {
+private:
+    struct Node {
+        GCPtr<Node> next;
+        long long value;
+    };
+
+    static constexpr int NODE_COUNT = 200000;
+    static constexpr int ROUNDS = 20;
+
+    static inline volatile long long sink = 0;
+
+    static void collect() {
+        // 等待GC线程完成一轮回收
+        gc::triggerGC();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        while (GCPhase::getGCPhase() != eGCPhase::NONE)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    static void walk(const GCPtr<Node>& head, const char* stage) {
+        using namespace std;
+        // 遍历一次以完成指针自愈，此后统计的是转移后的布局
+        long long sum = 0;
+        size_t adjacent = 0;
+        Node* prev = nullptr;
+        for (GCPtr<Node> p = head; p != nullptr; p = p->next) {
+            Node* cur = p.getRaw();
+            if (prev != nullptr && reinterpret_cast<char*>(cur) - reinterpret_cast<char*>(prev) == sizeof(Node))
+                adjacent++;
+            prev = cur;
+            sum += cur->value;
+        }
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            for (GCPtr<Node> p = head; p != nullptr; p = p->next)
+                sum += p->value;
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double ns = chrono::duration<double, nano>(end - start).count() / ROUNDS / NODE_COUNT;
+        cout << stage << ": " << 100.0 * adjacent / (NODE_COUNT - 1) << "% of successive nodes adjacent, "
+             << ns << " ns per node" << endl;
+        sink = sum;
+    }
+
+public:
+    static void run() {
+        using namespace std;
+        vector<GCPtr<Node>> nodes(NODE_COUNT);
+        {
+            // 结点与垃圾对象交替分配，使region的碎片率足以触发转移
+            vector<GCPtr<Node>> garbage(NODE_COUNT);
+            for (int i = 0; i < NODE_COUNT; i++) {
+                nodes[i] = gc::make_gc<Node>();
+                nodes[i]->value = i;
+                garbage[i] = gc::make_gc<Node>();
+            }
+        }
+        // 按随机顺序链接，使链表顺序与地址顺序无关
+        vector<int> order(NODE_COUNT);
+        for (int i = 0; i < NODE_COUNT; i++) order[i] = i;
+        shuffle(order.begin(), order.end(), mt19937(12345));
+        for (int i = 0; i + 1 < NODE_COUNT; i++)
+            nodes[order[i]]->next = nodes[order[i + 1]];
+        GCPtr<Node> head = nodes[order[0]];
+        nodes.clear();
+        nodes.shrink_to_fit();
+
+        cout << "Evacuation order benchmark: " << NODE_COUNT << " nodes, "
+             << (GCParameter::enableDepthFirstEvacuation ? "depth-first" : "address order") << " evacuation" << endl;
+        walk(head, "Before GC");
+        collect();
+        collect();
+        walk(head, "After GC");
+    }
+};
+
+#endif
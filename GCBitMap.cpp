@@ -1,4 +1,5 @@
 #include "GCBitMap.h"
+#include "GCUtil.h"
 
 GCBitMap::GCBitMap(void* region_start_addr, size_t region_size, IMemoryAllocator* memoryAllocator,
                    bool mark_obj_size, int iterate_step_size, int region_to_bitmap_ratio) :
@@ -150,6 +151,13 @@ unsigned int GCBitMap::getObjectSize(void* object_addr) const {
     return objSize;
 }
 
+void GCBitMap::prefetch(void* object_addr) const {
+    if (bitmap_arr == nullptr) return;
+    int offset_byte, offset_bit;
+    addr_to_bit(object_addr, offset_byte, offset_bit);
+    GC_PREFETCH(bitmap_arr + offset_byte);
+}
+
 GCBitMap::BitMapIterator GCBitMap::getIterator() const {
     return GCBitMap::BitMapIterator(*this);
 }
@@ -78,6 +78,9 @@ public:
 
     unsigned int getObjectSize(void* object_addr) const;
 
+    // 预取对象在位图中的标记字节，供标记时提前加载
+    void prefetch(void* object_addr) const;
+
     BitMapIterator getIterator() const;
 
     unsigned int alignUpSize(unsigned int) const;
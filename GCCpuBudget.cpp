@@ -0,0 +1,76 @@
+#include "GCCpuBudget.h"
+#include <iostream>
+#include <thread>
+
+std::atomic<bool> GCCpuBudget::in_cycle{false};
+std::atomic<bool> GCCpuBudget::budget_lifted{false};
+std::atomic<bool> GCCpuBudget::suspended{false};
+std::atomic<unsigned int> GCCpuBudget::current_cycle{0};
+std::atomic<size_t> GCCpuBudget::heap_growth{0};
+std::atomic<long long> GCCpuBudget::throttled_micros{0};
+thread_local GCCpuBudget::WorkerClock GCCpuBudget::worker_clock;
+
+void GCCpuBudget::beginCycle() {
+    if constexpr (!enabled) return;
+    heap_growth.store(0);
+    throttled_micros.store(0);
+    budget_lifted.store(false);
+    current_cycle.fetch_add(1);
+    in_cycle.store(true);
+}
+
+void GCCpuBudget::endCycle() {
+    if constexpr (!enabled) return;
+    in_cycle.store(false);
+    long long throttled = throttled_micros.load();
+    if (throttled > 0) {
+        std::clog << "Info: GC CPU budget throttled GC threads for " << throttled / 1000 << " ms in this cycle, "
+                  << "heap grew by " << heap_growth.load() / 1024 << " KB meanwhile" << std::endl;
+    }
+}
+
+void GCCpuBudget::suspend() {
+    if constexpr (!enabled) return;
+    suspended.store(true);
+}
+
+void GCCpuBudget::resume() {
+    if constexpr (!enabled) return;
+    suspended.store(false);
+}
+
+void GCCpuBudget::recordHeapGrowth(size_t size) {
+    if constexpr (!enabled) return;
+    if (!in_cycle.load(std::memory_order_relaxed)) return;
+    size_t growth = heap_growth.fetch_add(size) + size;
+    if (growth > GCParameter::gcBudgetHeapGrowthLimit && !budget_lifted.exchange(true)) {
+        std::clog << "Info: Heap grew by " << growth / 1024 << " KB during GC, exceeding gcBudgetHeapGrowthLimit; "
+                  << "lifting the GC CPU budget for the rest of this cycle" << std::endl;
+    }
+}
+
+void GCCpuBudget::checkpointSlow() {
+    worker_clock.countdown = CHECK_INTERVAL;
+    if (!in_cycle.load(std::memory_order_relaxed) || budget_lifted.load(std::memory_order_relaxed)) return;
+    if (suspended.load(std::memory_order_relaxed)) return;
+    auto now = std::chrono::steady_clock::now();
+    unsigned int cycle = current_cycle.load(std::memory_order_relaxed);
+    if (worker_clock.cycle != cycle) {
+        worker_clock.cycle = cycle;
+        worker_clock.slice_start = now;
+        return;
+    }
+    auto busy = std::chrono::duration_cast<std::chrono::microseconds>(now - worker_clock.slice_start).count();
+    if (busy < GCParameter::gcCpuSliceMicros) return;
+    if (busy > 4 * GCParameter::gcCpuSliceMicros) {
+        // 两次检查之间远超一个时间片，说明该线程期间处于空闲（如等待下一阶段的任务），不计入工作时间
+        worker_clock.slice_start = now;
+        return;
+    }
+    // 工作了busy微秒，休眠busy * (1 - budget) / budget微秒，使工作时间占比为budget
+    constexpr float budget = GCParameter::gcCpuBudget > 0.01f ? GCParameter::gcCpuBudget : 0.01f;
+    auto pause = static_cast<long long>(static_cast<float>(busy) * (1.0f - budget) / budget);
+    std::this_thread::sleep_for(std::chrono::microseconds(pause));
+    throttled_micros.fetch_add(pause, std::memory_order_relaxed);
+    worker_clock.slice_start = std::chrono::steady_clock::now();
+}
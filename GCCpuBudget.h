@@ -0,0 +1,61 @@
+#ifndef CPPGCPTR_GCCPUBUDGET_H
+#define CPPGCPTR_GCCPUBUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include "GCParameter.h"
+
+/* GC的CPU预算
+ * 以每个GC线程的占空比限制GC占用的CPU：GC线程在标记和转移的循环中周期性地调用checkpoint()，
+ * 每连续工作gcCpuSliceMicros微秒后休眠一段时间，使其工作时间占比不超过gcCpuBudget，从而把CPU让给应用线程
+ * 预算与堆增长之间的权衡：一轮GC期间新分配的region超过gcBudgetHeapGrowthLimit时，本轮不再限流，以免堆无限增长，并输出提示
+ * STW期间应用线程已暂停，限流只会延长停顿，因此由stop_the_world至resume_the_world之间暂停限流
+ * 一轮GC结束时若发生过限流，输出限流总时长以及期间堆的增长量
+ */
+class GCCpuBudget {
+private:
+    struct WorkerClock {
+        std::chrono::steady_clock::time_point slice_start;
+        int countdown = 0;
+        unsigned int cycle = 0;
+    };
+
+    static constexpr int CHECK_INTERVAL = 64;       // 每调用多少次checkpoint()读取一次时钟
+
+    static std::atomic<bool> in_cycle;
+    static std::atomic<bool> budget_lifted;
+    static std::atomic<bool> suspended;
+    static std::atomic<unsigned int> current_cycle;
+    static std::atomic<size_t> heap_growth;
+    static std::atomic<long long> throttled_micros;
+    static thread_local WorkerClock worker_clock;
+
+    static void checkpointSlow();
+
+public:
+    static constexpr bool enabled = GCParameter::gcCpuBudget < 1.0f;
+
+    // 由GC线程在一轮GC开始和结束时调用，仅此期间进行限流
+    static void beginCycle();
+
+    static void endCycle();
+
+    // 由GC线程在STW开始和结束时调用，期间checkpoint()不休眠
+    static void suspend();
+
+    static void resume();
+
+    // 在标记、转移等GC线程的循环中调用；未启用预算时为空操作
+    static void checkpoint() {
+        if constexpr (enabled) {
+            if (--worker_clock.countdown <= 0)
+                checkpointSlow();
+        }
+    }
+
+    // 记录一轮GC期间为新region申请的内存，供预算与堆增长之间的权衡使用
+    static void recordHeapGrowth(size_t size);
+};
+
+
+#endif //CPPGCPTR_GCCPUBUDGET_H
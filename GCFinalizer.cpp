@@ -0,0 +1,88 @@
+#include "GCFinalizer.h"
+#include <iostream>
+
+thread_local bool GCFinalizer::finalizing = false;
+
+GCFinalizer::GCFinalizer() : pending_count(0), finalized_count(0), backlog_warned(false), running(false), stop_(false) {
+    finalizer_thread = std::thread(&GCFinalizer::finalizerLoop, this);
+}
+
+GCFinalizer::~GCFinalizer() {
+    {
+        std::unique_lock<std::mutex> lock(tasks_mutex);
+        stop_ = true;
+    }
+    tasks_condition.notify_all();
+    if (finalizer_thread.joinable())
+        finalizer_thread.join();
+}
+
+void GCFinalizer::enqueue(Task&& task) {
+    size_t object_count = task.objects.size();
+    {
+        std::unique_lock<std::mutex> lock(tasks_mutex);
+        tasks.push_back(std::move(task));
+        size_t pending = pending_count.fetch_add(object_count) + object_count;
+        if (pending > GCParameter::finalizerBacklogWarningThreshold && !backlog_warned) {
+            backlog_warned = true;
+            std::clog << "Info: Finalizer backlog reached " << pending << " objects, "
+                      << "destructors are running slower than objects die" << std::endl;
+        }
+    }
+    tasks_condition.notify_one();
+}
+
+void GCFinalizer::submit(Batch&& batch, std::shared_ptr<std::atomic<size_t>> region_pending) {
+    if (batch.empty()) return;
+    Task task;
+    task.objects = std::move(batch);
+    task.region_pending = std::move(region_pending);
+    enqueue(std::move(task));
+}
+
+void GCFinalizer::submitFree(IMemoryAllocator* memoryAllocator, void* memory, size_t size) {
+    Task task;
+    task.memoryAllocator = memoryAllocator;
+    task.memory = memory;
+    task.memory_size = size;
+    enqueue(std::move(task));
+}
+
+void GCFinalizer::waitUntilIdle() {
+    std::unique_lock<std::mutex> lock(tasks_mutex);
+    idle_condition.wait(lock, [this] { return tasks.empty() && !running; });
+}
+
+void GCFinalizer::finalizerLoop() {
+    finalizing = true;
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            tasks_condition.wait(lock, [this] { return stop_ || !tasks.empty(); });
+            if (tasks.empty()) break;       // 已请求退出，且所有任务均已执行完毕
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            running = true;
+        }
+        for (auto& [object_addr, descriptor] : task.objects) {
+            descriptor->destructor(object_addr);
+        }
+        if (task.region_pending != nullptr)
+            task.region_pending->fetch_sub(1);
+        if (task.memoryAllocator != nullptr)
+            task.memoryAllocator->free(task.memory, task.memory_size);
+        size_t object_count = task.objects.size();
+        task.objects.clear();
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            running = false;
+            finalized_count.fetch_add(object_count);
+            size_t pending = pending_count.fetch_sub(object_count) - object_count;
+            if (pending * 2 < GCParameter::finalizerBacklogWarningThreshold)
+                backlog_warned = false;
+            if (tasks.empty())
+                idle_condition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef CPPGCPTR_GCFINALIZER_H
+#define CPPGCPTR_GCFINALIZER_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "IMemoryAllocator.h"
+#include "GCTypeDescriptor.h"
+#include "GCParameter.h"
+
+/* 终结器线程
+ * 清扫和转移阶段不再直接调用死亡对象的析构函数，而是取出对象的类型描述符，按region打包成一批提交给终结器线程，
+ * 由终结器线程在GC周期之外批量执行，使析构函数的耗时不再计入GC的暂停与清扫时间
+ * 内存的归还顺序：含有待终结对象的region被释放时，其内存不立即归还，而是作为一项释放任务排在同一个先进先出队列中，
+ * 由于该region的所有批次都先于释放任务入队，因此内存总是在其中对象的析构函数全部执行完毕后才被归还
+ * 终结器线程执行析构函数时，死亡对象中的GCPtr析构不会产生SATB：死亡对象在下一轮的快照中同样不可达，其引用的对象无需保护
+ * 积压的待终结对象数可通过getPendingCount()（即gc::getFinalizerBacklog()）获取，超过finalizerBacklogWarningThreshold时输出提示
+ */
+class GCFinalizer {
+public:
+    using Batch = std::vector<std::pair<void*, const GCTypeDescriptor*>>;
+
+private:
+    struct Task {
+        Batch objects;
+        IMemoryAllocator* memoryAllocator = nullptr;    // 非空时为释放任务，在此前入队的析构函数全部执行后归还内存
+        void* memory = nullptr;
+        size_t memory_size = 0;
+        std::shared_ptr<std::atomic<size_t>> region_pending;    // 所属region尚未执行完的批次数，本批执行完毕后减一
+    };
+
+    static thread_local bool finalizing;
+
+    std::deque<Task> tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_condition;
+    std::condition_variable idle_condition;
+    std::thread finalizer_thread;
+    std::atomic<size_t> pending_count;
+    std::atomic<size_t> finalized_count;
+    bool backlog_warned;
+    bool running;
+    bool stop_;
+
+    void enqueue(Task&& task);
+
+    void finalizerLoop();
+
+public:
+    GCFinalizer();
+
+    // 析构时执行完所有已提交的析构函数和释放任务后再退出终结器线程
+    ~GCFinalizer();
+
+    GCFinalizer(const GCFinalizer&) = delete;
+
+    // 提交一批死亡对象的析构函数；region_pending非空时，本批执行完毕后将其减一
+    void submit(Batch&& batch, std::shared_ptr<std::atomic<size_t>> region_pending = nullptr);
+
+    // 在此前提交的析构函数全部执行后，将memory归还给memoryAllocator
+    void submitFree(IMemoryAllocator* memoryAllocator, void* memory, size_t size);
+
+    // 等待队列中的所有任务执行完毕
+    void waitUntilIdle();
+
+    // 已提交但尚未执行析构函数的对象数
+    size_t getPendingCount() const {
+        return pending_count.load();
+    }
+
+    size_t getFinalizedCount() const {
+        return finalized_count.load();
+    }
+
+    // 当前线程是否为正在执行析构函数的终结器线程
+    static bool isFinalizing() {
+        return finalizing;
+    }
+};
+
+
+#endif //CPPGCPTR_GCFINALIZER_H
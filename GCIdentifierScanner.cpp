@@ -0,0 +1,142 @@
+#include "GCIdentifierScanner.h"
+#include "GCPtrBase.h"
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GC_SIMD_X86 1
+#include <immintrin.h>
+#if _MSC_VER
+#include <intrin.h>
+#define GC_TARGET(x)
+#else
+#define GC_TARGET(x) __attribute__((target(x)))
+#endif
+#else
+#define GC_SIMD_X86 0
+#endif
+
+namespace {
+    constexpr size_t STRIDE = sizeof(void*);
+    constexpr size_t HEAD_OFFSET = sizeof(void*);     // 标识头位于虚表指针之后
+
+#if GC_SIMD_X86
+    // 每个64位字的低32位对应一个候选位置，比较结果掩码中只取偶数位
+    char* findSSE2(char* first, char* last) {
+        const __m128i head = _mm_set1_epi32(GCPTR_IDENTIFIER_HEAD);
+        char* n = first;
+        for (; n + 3 * STRIDE <= last; n += 4 * STRIDE) {
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n + HEAD_OFFSET));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n + HEAD_OFFSET + 16));
+            int mask0 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v0, head))) & 0x5;
+            int mask1 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v1, head))) & 0x5;
+            unsigned int mask = static_cast<unsigned int>(mask0 | mask1 << 4);
+            if (mask != 0)
+                return n + std::countr_zero(mask) / 2 * STRIDE;
+        }
+        return GCIdentifierScanner::findNextScalar(n, last);
+    }
+
+    GC_TARGET("avx2")
+    char* findAVX2(char* first, char* last) {
+        const __m256i head = _mm256_set1_epi32(GCPTR_IDENTIFIER_HEAD);
+        char* n = first;
+        for (; n + 3 * STRIDE <= last; n += 4 * STRIDE) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n + HEAD_OFFSET));
+            unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, head)))) & 0x55;
+            if (mask != 0)
+                return n + std::countr_zero(mask) / 2 * STRIDE;
+        }
+        return GCIdentifierScanner::findNextScalar(n, last);
+    }
+
+    GC_TARGET("avx512f")
+    char* findAVX512(char* first, char* last) {
+        const __m512i head = _mm512_set1_epi32(GCPTR_IDENTIFIER_HEAD);
+        char* n = first;
+        for (; n + 7 * STRIDE <= last; n += 8 * STRIDE) {
+            __m512i v = _mm512_loadu_si512(reinterpret_cast<const void*>(n + HEAD_OFFSET));
+            unsigned int mask = static_cast<unsigned int>(_mm512_cmpeq_epi32_mask(v, head)) & 0x5555;
+            if (mask != 0)
+                return n + std::countr_zero(mask) / 2 * STRIDE;
+        }
+        return GCIdentifierScanner::findNextScalar(n, last);
+    }
+
+#if _MSC_VER
+    bool osSupportsAVX(unsigned long long required_xcr0) {
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        return osxsave && (_xgetbv(0) & required_xcr0) == required_xcr0;
+    }
+#endif
+#endif
+}
+
+std::atomic<GCIdentifierScanner::FindFunc> GCIdentifierScanner::find_func{&GCIdentifierScanner::resolveAndFind};
+
+char* GCIdentifierScanner::resolveAndFind(char* first, char* last) {
+    // 首次调用时按CPU支持的指令集选择实现
+    FindFunc func = getFindFunc(getSupportedLevel());
+    find_func.store(func, std::memory_order_relaxed);
+    return func(first, last);
+}
+
+char* GCIdentifierScanner::findNextScalar(char* first, char* last) {
+    for (char* n = first; n <= last; n += STRIDE) {
+        if (*reinterpret_cast<int*>(n + HEAD_OFFSET) == GCPTR_IDENTIFIER_HEAD)
+            return n;
+    }
+    return nullptr;
+}
+
+GCIdentifierScanner::Level GCIdentifierScanner::getSupportedLevel() {
+#if GC_SIMD_X86
+#if _MSC_VER
+    int info[4];
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 16)) && osSupportsAVX(0xe6))      // AVX-512F，需要操作系统保存ZMM寄存器
+        return Level::AVX512;
+    if ((info[1] & (1 << 5)) && osSupportsAVX(0x6))        // AVX2
+        return Level::AVX2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Level::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return Level::AVX2;
+#endif
+    return Level::SSE2;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+GCIdentifierScanner::FindFunc GCIdentifierScanner::getFindFunc(Level level) {
+    switch (level) {
+#if GC_SIMD_X86
+        case Level::AVX512:
+            return &findAVX512;
+        case Level::AVX2:
+            return &findAVX2;
+        case Level::SSE2:
+            return &findSSE2;
+#endif
+        default:
+            return &GCIdentifierScanner::findNextScalar;
+    }
+}
+
+const char* GCIdentifierScanner::getLevelName(Level level) {
+    switch (level) {
+        case Level::AVX512:
+            return "AVX-512";
+        case Level::AVX2:
+            return "AVX2";
+        case Level::SSE2:
+            return "SSE2";
+        default:
+            return "Scalar";
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef CPPGCPTR_GCIDENTIFIERSCANNER_H
+#define CPPGCPTR_GCIDENTIFIERSCANNER_H
+
+#include <cstddef>
+#include <atomic>
+
+/* 在对象内存中查找GCPtr标识头的候选位置
+ * 对于[first, last]中按指针大小步进的每个位置n，若n偏移一个虚表指针处的int等于GCPTR_IDENTIFIER_HEAD，则n为候选位置
+ * x86-64下使用SIMD一次比较32~64字节（SSE2为基线，运行时检测到AVX2/AVX-512时自动切换），其它平台使用标量实现，各实现结果完全一致
+ */
+class GCIdentifierScanner {
+public:
+    enum class Level {
+        SCALAR, SSE2, AVX2, AVX512
+    };
+
+    using FindFunc = char* (*)(char* first, char* last);
+
+private:
+    // 多个GC线程可能同时首次调用，函数指针本身的读写须为原子操作，relaxed即可（各实现结果一致）
+    static std::atomic<FindFunc> find_func;
+
+    static char* resolveAndFind(char* first, char* last);
+
+public:
+    // 返回[first, last]中首个候选位置，不存在则返回nullptr
+    static char* findNext(char* first, char* last) {
+        return find_func.load(std::memory_order_relaxed)(first, last);
+    }
+
+    static char* findNextScalar(char* first, char* last);
+
+    static Level getSupportedLevel();
+
+    static FindFunc getFindFunc(Level level);
+
+    static const char* getLevelName(Level level);
+};
+
+
+#endif //CPPGCPTR_GCIDENTIFIERSCANNER_H
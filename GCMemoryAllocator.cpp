@@ -5,6 +5,10 @@
 
 thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallAllocatingRegion;
 thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallRelocatingRegion;
+thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallLeafAllocatingRegion;
+thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallLeafRelocatingRegion;
+thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallHotRelocatingRegion;
+thread_local std::shared_ptr<GCRegion> GCMemoryAllocator::smallLeafHotRelocatingRegion;
 
 GCMemoryAllocator::GCMemoryAllocator(bool useInternalMemoryManager, bool enableParallelClear,
                                      int gcThreadCount, ThreadPoolExecutor* gcThreadPool) {
@@ -12,6 +16,15 @@ GCMemoryAllocator::GCMemoryAllocator(bool useInternalMemoryManager, bool enableP
     this->enableParallelClear = enableParallelClear;
     this->gcThreadCount = gcThreadCount;
     this->threadPool = gcThreadPool;
+    this->incremental_relocation = false;
+    this->incremental_sweep_stage = 0;
+    this->incremental_sweep_cursor = 0;
+    this->incremental_sweep_que = 0;
+    this->compacting = false;
+    this->evacuation_reserve_selected = 0;
+    this->evacuation_deferred_regions = 0;
+    this->evacuation_failed_regions = 0;
+    this->evacuation_reserve_used = 0;
     if constexpr (GCParameter::enableHashPool)
         this->poolCount = std::thread::hardware_concurrency();
     else
@@ -34,50 +47,71 @@ GCMemoryAllocator::GCMemoryAllocator(bool useInternalMemoryManager, bool enableP
     this->regionMapBufMtx1 = std::make_unique<std::mutex[]>(poolCount);
 }
 
-std::pair<void*, std::shared_ptr<GCRegion>> GCMemoryAllocator::allocate(size_t size) {
+std::pair<void*, std::shared_ptr<GCRegion>> GCMemoryAllocator::allocate(size_t size, bool leaf) {
+    if constexpr (!GCParameter::enableLeafRegion)
+        leaf = false;
     if (size <= GCRegion::TINY_OBJECT_THRESHOLD) {
+        // 迷你对象小于GCPtr，必然不含GCPtr，迷你region本身即为叶子region
         return this->allocate_from_region(size, RegionEnum::TINY);
     } else if (size <= GCRegion::SMALL_OBJECT_THRESHOLD) {
-        return this->allocate_from_region(size, RegionEnum::SMALL);
+        return this->allocate_from_region(size, RegionEnum::SMALL, false, leaf);
     } else if (size <= GCRegion::MEDIUM_OBJECT_THRESHOLD) {
-        return this->allocate_from_region(size, RegionEnum::MEDIUM);
+        return this->allocate_from_region(size, RegionEnum::MEDIUM, false, leaf);
     } else {
-        return this->allocate_from_region(size, RegionEnum::LARGE);
+        return this->allocate_from_region(size, RegionEnum::LARGE, false, leaf);
     }
 }
 
-std::pair<void*, std::shared_ptr<GCRegion>> GCMemoryAllocator::relocate(size_t size) {
-    if (size <= GCRegion::SMALL_OBJECT_THRESHOLD && size > GCRegion::TINY_OBJECT_THRESHOLD) {
-        return this->allocate_from_region(size, RegionEnum::SMALL, true);
+std::pair<void*, std::shared_ptr<GCRegion>> GCMemoryAllocator::relocate(size_t size, bool leaf, bool hot) {
+    if constexpr (!GCParameter::enableLeafRegion)
+        leaf = false;
+    if constexpr (!GCParameter::enableHotColdRelocation)
+        hot = false;
+    // 各类region均以relocate为true申请，使新的目标region计入转移预留空间
+    if (size <= GCRegion::TINY_OBJECT_THRESHOLD) {
+        return this->allocate_from_region(size, RegionEnum::TINY, true);
+    } else if (size <= GCRegion::SMALL_OBJECT_THRESHOLD) {
+        // 冷热分离只作用于小对象：迷你region由所有线程共用，中对象和大对象本身已占据较多的缓存行和页
+        return this->allocate_from_region(size, RegionEnum::SMALL, true, leaf, false, hot);
+    } else if (size <= GCRegion::MEDIUM_OBJECT_THRESHOLD) {
+        return this->allocate_from_region(size, RegionEnum::MEDIUM, true, leaf);
     } else {
-        return this->allocate(size);
+        return this->allocate_from_region(size, RegionEnum::LARGE, true, leaf);
     }
 }
 
+std::pair<void*, std::shared_ptr<GCRegion>> GCMemoryAllocator::relocateRun(size_t size, RegionEnum regionType, bool leaf) {
+    if constexpr (!GCParameter::enableLeafRegion)
+        leaf = false;
+    if (regionType == RegionEnum::TINY)
+        return this->allocate_from_region(size, RegionEnum::TINY, true, false, true);
+    return this->allocate_from_region(size, RegionEnum::SMALL, true, leaf, true);
+}
+
 std::pair<void*, std::shared_ptr<GCRegion>>
-GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool relocate) {
+GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool relocate, bool leaf, bool run, bool hot) {
     if (size == 0) return std::make_pair(nullptr, nullptr);
+    // 叶子对象与普通对象分别从各自的当前region中分配，保证叶子region中只有不含GCPtr的对象
+    // 转移时热对象与冷对象同样分别从各自的当前region中分配
+    std::shared_ptr<GCRegion>& smallCurrentRegion =
+            relocate ? (leaf ? (hot ? smallLeafHotRelocatingRegion : smallLeafRelocatingRegion)
+                             : (hot ? smallHotRelocatingRegion : smallRelocatingRegion))
+                     : (leaf ? smallLeafAllocatingRegion : smallAllocatingRegion);
+    std::atomic<std::shared_ptr<GCRegion>>& mediumCurrentRegion = leaf ? mediumLeafAllocatingRegion : mediumAllocatingRegion;
     while (true) {
         // 从已有region中寻找空闲区域
         std::shared_ptr<GCRegion> region;
 
         switch (regionType) {
             case RegionEnum::SMALL: {
-                if (!relocate) {
-                    if (smallAllocatingRegion != nullptr) {
-                        void* addr = smallAllocatingRegion->allocate(size);
-                        if (addr != nullptr) return std::make_pair(addr, smallAllocatingRegion);
-                    }
-                } else {
-                    if (smallRelocatingRegion != nullptr) {
-                        void* addr = smallRelocatingRegion->allocate(size);
-                        if (addr != nullptr) return std::make_pair(addr, smallRelocatingRegion);
-                    }
+                if (smallCurrentRegion != nullptr) {
+                    void* addr = run ? smallCurrentRegion->allocateRun(size) : smallCurrentRegion->allocate(size);
+                    if (addr != nullptr) return std::make_pair(addr, smallCurrentRegion);
                 }
             }
                 break;
             case RegionEnum::MEDIUM:
-                region = this->mediumAllocatingRegion.load();
+                region = mediumCurrentRegion.load();
                 if (region != nullptr) {
                     void* addr = region->allocate(size);
                     if (addr != nullptr) return std::make_pair(addr, region);
@@ -86,7 +120,7 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
             case RegionEnum::TINY:
                 region = this->tinyAllocatingRegion.load();
                 if (region != nullptr) {
-                    void* addr = region->allocate(size);
+                    void* addr = run ? region->allocateRun(size) : region->allocate(size);
                     if (addr != nullptr) return std::make_pair(addr, region);
                 }
                 break;
@@ -112,20 +146,25 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
                 break;
         }
 
-        void* new_region_memory = this->allocate_new_memory(regionSize);
+        // 转移只能使用预留空间，预留空间耗尽或无法从操作系统申请到内存时转移失败，由调用方原地保留源region
+        if (relocate && !chargeEvacuationReserve(regionSize))
+            return std::make_pair(nullptr, nullptr);
+        void* new_region_memory = this->allocate_new_memory(regionSize, relocate);
+        if (new_region_memory == nullptr) {
+            if (relocate) releaseEvacuationReserve(regionSize);
+            return std::make_pair(nullptr, nullptr);
+        }
+        GCCpuBudget::recordHeapGrowth(regionSize);
         if (GCParameter::fillZeroForNewRegion)
             memset(new_region_memory, 0, regionSize);
-        std::shared_ptr<GCRegion> new_region = std::make_shared<GCRegion>(regionType, new_region_memory, regionSize, this);
+        std::shared_ptr<GCRegion> new_region = std::make_shared<GCRegion>(regionType, new_region_memory, regionSize, this, leaf);
 
         std::unique_lock<std::shared_mutex> region_map_lock(regionMapMtx, std::defer_lock);
         if (regionType != RegionEnum::SMALL) region_map_lock.lock();
 
         switch (regionType) {
             case RegionEnum::SMALL: {
-                if (relocate)
-                    smallRelocatingRegion = new_region;
-                else
-                    smallAllocatingRegion = new_region;
+                smallCurrentRegion = new_region;
 
                 int pool_idx = getPoolIdx();
                 if constexpr (enableRegionMapBuffer) {
@@ -168,8 +207,8 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
                 
                 break;
             case RegionEnum::MEDIUM:
-                if (mediumAllocatingRegion.load(std::memory_order_acquire) == region) {
-                    mediumAllocatingRegion.store(new_region, std::memory_order_release);
+                if (mediumCurrentRegion.load(std::memory_order_acquire) == region) {
+                    mediumCurrentRegion.store(new_region, std::memory_order_release);
                     regionMap.emplace(new_region->getStartAddr(), new_region.get());
                     region_map_lock.unlock();
                     if constexpr (useConcurrentLinkedList) {
@@ -181,6 +220,7 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
                 } else {
                     region_map_lock.unlock();
                     new_region->free();
+                    if (relocate) releaseEvacuationReserve(regionSize);
                 }
 
                 break;
@@ -198,6 +238,7 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
                 } else {
                     region_map_lock.unlock();
                     new_region->free();
+                    if (relocate) releaseEvacuationReserve(regionSize);
                 }
 
                 break;
@@ -216,9 +257,9 @@ GCMemoryAllocator::allocate_from_region(size_t size, RegionEnum regionType, bool
     }
 }
 
-void* GCMemoryAllocator::allocate_new_memory(size_t size) {
+void* GCMemoryAllocator::allocate_new_memory(size_t size, bool relocate) {
     if (enableInternalMemoryManager)
-        return this->allocate_from_freelist(size);
+        return this->allocate_from_freelist(size, relocate);
     else
         return malloc(size);
 }
@@ -227,7 +268,7 @@ void* GCMemoryAllocator::allocate_raw(size_t size) {
     return allocate_new_memory(size);
 }
 
-void* GCMemoryAllocator::allocate_from_freelist(size_t size) {
+void* GCMemoryAllocator::allocate_from_freelist(size_t size, bool relocate) {
     int pool_idx = getPoolIdx();
     // 优先从threadLocal的memoryPool分配，若空间不足从别的steal过来，还不够则触发malloc并分配到memoryPool里
     void* address = memoryPools[pool_idx].allocate(size);
@@ -239,7 +280,7 @@ void* GCMemoryAllocator::allocate_from_freelist(size_t size) {
     do {
         memoryPools[pool_idx].add_memory(size);
         address = memoryPools[pool_idx].allocate(size);
-    } while (address == nullptr);
+    } while (address == nullptr && !relocate);     // 转移时只尝试一次，失败则放弃转移而不是在内存紧张时无限重试
     return address;
 }
 
@@ -275,17 +316,9 @@ void GCMemoryAllocator::triggerClear() {
                 for (int i = 0; i < poolCount; i++) {
                     std::shared_lock<std::shared_mutex> lock(this->smallRegionQueMtxs[i]);
                     if (enableParallelClear && smallRegionQues[i].size() >= PARALLEL_THRESHOLD) {
-                        size_t snum = smallRegionQues[i].size() / gcThreadCount;
-                        for (int tid = 0; tid < gcThreadCount; tid++) {
-                            threadPool->execute([this, i, tid, snum] {
-                                size_t startIndex = tid * snum;
-                                size_t endIndex = (tid == gcThreadCount - 1) ? smallRegionQues[i].size() : (tid + 1) * snum;
-                                for (size_t j = startIndex; j < endIndex; j++) {
-                                    smallRegionQues[i][j]->clearUnmarked();
-                                }
-                            });
-                        }
-                        threadPool->waitForTaskComplete(gcThreadCount);
+                        GCUtil::parallel_for(threadPool, getWorkerCount(smallRegionQues[i].size()), smallRegionQues[i].size(), [this, i](size_t j) {
+                            smallRegionQues[i][j]->clearUnmarked();
+                        });
                     } else {
                         for (auto& region : smallRegionQues[i]) {
                             region->clearUnmarked();
@@ -296,17 +329,9 @@ void GCMemoryAllocator::triggerClear() {
             {
                 std::shared_lock<std::shared_mutex> lock(this->mediumRegionQueMtx);
                 if (enableParallelClear && mediumRegionQue.size() >= PARALLEL_THRESHOLD) {
-                    size_t snum = mediumRegionQue.size() / gcThreadCount;
-                    for (int tid = 0; tid < gcThreadCount; tid++) {
-                        threadPool->execute([this, tid, snum] {
-                            size_t startIndex = tid * snum;
-                            size_t endIndex = (tid == gcThreadCount - 1) ? mediumRegionQue.size() : (tid + 1) * snum;
-                            for (size_t j = startIndex; j < endIndex; j++) {
-                                mediumRegionQue[j]->clearUnmarked();
-                            }
-                        });
-                    }
-                    threadPool->waitForTaskComplete(gcThreadCount);
+                    GCUtil::parallel_for(threadPool, getWorkerCount(mediumRegionQue.size()), mediumRegionQue.size(), [this](size_t j) {
+                        mediumRegionQue[j]->clearUnmarked();
+                    });
                 } else {
                     for (auto& region : mediumRegionQue) {
                         region->clearUnmarked();
@@ -335,31 +360,16 @@ void GCMemoryAllocator::triggerRelocation() {
     if (GCParameter::delayRelocationPhase)
         GCUtil::sleep(0.05);        // 为PtrGuard给予50ms析构
 
-    if (enableParallelClear) {
-        size_t snum = evacuationQue.size() / gcThreadCount;
-        for (int tid = 0; tid < gcThreadCount; tid++) {
-            threadPool->execute([this, tid, snum] {
-                size_t startIndex = tid * snum;
-                size_t endIndex = (tid == gcThreadCount - 1) ? evacuationQue.size() : (tid + 1) * snum;
-                for (size_t j = startIndex; j < endIndex; j++) {
-                    evacuationQue[j]->triggerRelocation();
-                }
-            });
-        }
-        threadPool->waitForTaskComplete(gcThreadCount);
+    if (enableParallelClear && !compacting) {
+        // 各region的存活对象数相差悬殊，按块动态领取
+        GCUtil::parallel_for(threadPool, getWorkerCount(evacuationQue.size()), evacuationQue.size(), [this](size_t j) {
+            evacuationQue[j]->triggerRelocation();
+        });
 
         if constexpr (immediateClear) {
-            size_t snum = liveQue.size() / gcThreadCount;
-            for (int tid = 0; tid < gcThreadCount; tid++) {
-                threadPool->execute([this, tid, snum] {
-                    size_t startIndex = tid * snum;
-                    size_t endIndex = (tid == gcThreadCount - 1) ? liveQue.size() : (tid + 1) * snum;
-                    for (size_t j = startIndex; j < endIndex; j++) {
-                        liveQue[j]->clearUnmarked();
-                    }
-                });
-            }
-            threadPool->waitForTaskComplete(gcThreadCount);
+            GCUtil::parallel_for(threadPool, getWorkerCount(liveQue.size()), liveQue.size(), [this](size_t j) {
+                liveQue[j]->clearUnmarked();
+            });
         }
     } else {
         for (int i = 0; i < evacuationQue.size(); i++) {
@@ -372,18 +382,12 @@ void GCMemoryAllocator::triggerRelocation() {
         }
     }
 
+    keepFailedEvacuations();
+
     if (enableParallelClear) {
-        size_t snum = evacuationQue.size() / gcThreadCount;
-        for (int tid = 0; tid < gcThreadCount; tid++) {
-            threadPool->execute([this, tid, snum] {
-                size_t startIndex = tid * snum;
-                size_t endIndex = (tid == gcThreadCount - 1) ? evacuationQue.size() : (tid + 1) * snum;
-                for (size_t j = startIndex; j < endIndex; j++) {
-                    evacuationQue[j]->free();
-                }
-            });
-        }
-        threadPool->waitForTaskComplete(gcThreadCount);
+        GCUtil::parallel_for(threadPool, getWorkerCount(evacuationQue.size()), evacuationQue.size(), [this](size_t j) {
+            evacuationQue[j]->free();
+        });
     } else {
         for (auto& region : evacuationQue) {
             region->free();
@@ -397,23 +401,119 @@ void GCMemoryAllocator::triggerRelocation() {
     }
 }
 
+void GCMemoryAllocator::beginIncrementalSweep(bool relocation) {
+    incremental_relocation = relocation;
+    incremental_sweep_stage = 0;
+    incremental_sweep_cursor = 0;
+    incremental_sweep_que = 0;
+}
+
+bool GCMemoryAllocator::incrementalSweepStep() {
+    if (GCPhase::getGCPhase() != eGCPhase::SWEEP) {
+        std::cerr << "Wrong phase, should in sweeping phase to trigger incremental sweep." << std::endl;
+        return false;
+    }
+    if constexpr (useConcurrentLinkedList) {
+        // 链表版本暂不支持拆分，一次完成
+        if (incremental_relocation)
+            triggerRelocation();
+        else
+            triggerClear();
+        return false;
+    }
+    if (incremental_relocation) {
+        // 与triggerRelocation()的步骤相同：转移region，清除存活region中的垃圾对象，释放已转移的region，释放大对象region
+        switch (incremental_sweep_stage) {
+            case 0:
+                if (incremental_sweep_cursor < evacuationQue.size()) {
+                    evacuationQue[incremental_sweep_cursor++]->triggerRelocation();
+                    return true;
+                }
+                break;
+            case 1:
+                if constexpr (immediateClear) {
+                    if (incremental_sweep_cursor < liveQue.size()) {
+                        liveQue[incremental_sweep_cursor++]->clearUnmarked();
+                        return true;
+                    }
+                }
+                break;
+            case 2:
+                if (incremental_sweep_cursor == 0)
+                    keepFailedEvacuations();
+                if (incremental_sweep_cursor < evacuationQue.size()) {
+                    evacuationQue[incremental_sweep_cursor++]->free();
+                    return true;
+                }
+                break;
+            default:
+                clearFreeRegion(largeRegionQue, largeRegionQueMtx);
+                return false;
+        }
+    } else {
+        // 与triggerClear()的步骤相同：清除各region中的垃圾对象，释放clearQue中的region，释放大对象region
+        switch (incremental_sweep_stage) {
+            case 0:
+                if constexpr (immediateClear || GCParameter::enableDestructorSupport) {
+                    if (clearUnmarkedStep())
+                        return true;
+                }
+                removeClearedRegionMap();
+                break;
+            case 1:
+                if (incremental_sweep_cursor < clearQue.size()) {
+                    clearQue[incremental_sweep_cursor]->clearUnmarked();
+                    clearQue[incremental_sweep_cursor]->free();
+                    incremental_sweep_cursor++;
+                    return true;
+                }
+                clearQue.clear();
+                break;
+            default:
+                clearFreeRegion(largeRegionQue, largeRegionQueMtx);
+                return false;
+        }
+    }
+    incremental_sweep_stage++;
+    incremental_sweep_cursor = 0;
+    return true;
+}
+
+bool GCMemoryAllocator::clearUnmarkedStep() {
+    while (incremental_sweep_que <= poolCount + 1) {
+        std::shared_ptr<GCRegion> region;
+        if (incremental_sweep_que < poolCount) {
+            std::shared_lock<std::shared_mutex> lock(smallRegionQueMtxs[incremental_sweep_que]);
+            if (incremental_sweep_cursor < smallRegionQues[incremental_sweep_que].size())
+                region = smallRegionQues[incremental_sweep_que][incremental_sweep_cursor++];
+        } else if (incremental_sweep_que == poolCount) {
+            std::shared_lock<std::shared_mutex> lock(mediumRegionQueMtx);
+            if (incremental_sweep_cursor < mediumRegionQue.size())
+                region = mediumRegionQue[incremental_sweep_cursor++];
+        } else {
+            std::shared_lock<std::shared_mutex> lock(tinyRegionQueMtx);
+            if (incremental_sweep_cursor < tinyRegionQue.size())
+                region = tinyRegionQue[incremental_sweep_cursor++];
+        }
+        if (region != nullptr) {
+            region->clearUnmarked();
+            return true;
+        }
+        incremental_sweep_que++;
+        incremental_sweep_cursor = 0;
+    }
+    return false;
+}
+
 void GCMemoryAllocator::processClearQue() {
     removeClearedRegionMap();
 
     const int PARALLEL_THRESHOLD = 8;
     if (enableParallelClear && clearQue.size() > PARALLEL_THRESHOLD) {
-        size_t snum = clearQue.size() / gcThreadCount;
-        for (int tid = 0; tid < gcThreadCount; tid++) {
-            threadPool->execute([this, tid, snum] {
-                size_t startIndex = tid * snum;
-                size_t endIndex = (tid == gcThreadCount - 1) ? clearQue.size() : (tid + 1) * snum;
-                for (size_t j = startIndex; j < endIndex; j++) {
-                    clearQue[j]->clearUnmarked();
-                    clearQue[j]->free();
-                }
-            });
-        }
-        threadPool->waitForTaskComplete(gcThreadCount);
+        GCUtil::parallel_for(threadPool, getWorkerCount(clearQue.size()), clearQue.size(), [this](size_t j) {
+            clearQue[j]->clearUnmarked();
+            clearQue[j]->free();
+        });
     } else {
         for (int i = 0; i < clearQue.size(); i++) {
             clearQue[i]->clearUnmarked();
@@ -423,13 +523,18 @@ void GCMemoryAllocator::processClearQue() {
     clearQue.clear();
 }
 
-void GCMemoryAllocator::SelectRelocationSet() {
+void GCMemoryAllocator::SelectRelocationSet(bool compact) {
     if (GCPhase::getGCPhase() != eGCPhase::SWEEP) {
         std::cerr << "Wrong phase, should in sweeping phase to trigger select relocation set." << std::endl;
         return;
     }
     this->evacuationQue.clear();
     if constexpr (immediateClear) this->liveQue.clear();
+    this->compacting = compact;
+    this->evacuation_reserve_selected = 0;
+    this->evacuation_deferred_regions = 0;
+    this->evacuation_failed_regions = 0;
+    this->evacuation_reserve_used = 0;
     if constexpr (useConcurrentLinkedList) {
         for (int i = 0; i < poolCount; i++)
             selectRelocationSet(this->smallRegionLists[i]);
@@ -441,6 +546,18 @@ void GCMemoryAllocator::SelectRelocationSet() {
         selectRelocationSet(mediumRegionQue, mediumRegionQueMtx);
         selectRelocationSet(tinyRegionQue, tinyRegionQueMtx);
     }
+    if (compacting) {
+        // 存活对象多的region先转移，使其对象连续地填满目标region，存活对象少的region最后填补余下的空间
+        std::stable_sort(evacuationQue.begin(), evacuationQue.end(),
+                         [](const std::shared_ptr<GCRegion>& a, const std::shared_ptr<GCRegion>& b) {
+                             return a->getLiveSize() > b->getLiveSize();
+                         });
+        std::clog << "Info: Compacting " << evacuationQue.size() << " regions" << std::endl;
+    }
+    if (evacuation_deferred_regions != 0) {
+        std::clog << "Info: Evacuation reserve limited the relocation set to " << evacuation_reserve_selected / 1024
+                  << " KB of live objects, " << evacuation_deferred_regions << " regions deferred" << std::endl;
+    }
     removeEvacuatedRegionMap();
 }
 
@@ -450,8 +567,9 @@ void GCMemoryAllocator::selectRelocationSet(std::deque<std::shared_ptr<GCRegion>
     for (auto it = regionQue.begin(); it != regionQue.end();) {
         std::shared_ptr<GCRegion>& region = *it;
         if (!region->isEvacuated()) {
-            if (region.use_count() == 1 || region->needEvacuate() &&
-                (GCParameter::doNotRelocatePtrGuard ? region->zero_use_count() : true)) {
+            bool stack_pinned = region->testAndClearStackPinned();    // 被线程栈引用的region本轮不可重定位
+            bool kept_in_place = region->testAndClearKeptInPlace();   // 上一轮转移失败的region本轮不再转移
+            if (!stack_pinned && !kept_in_place && shouldEvacuate(region, 1) && withinEvacuationReserve(region.get())) {
                 region->setEvacuated();
                 this->evacuationQue.emplace_back(std::move(region));
                 it = regionQue.erase(it);
@@ -471,8 +589,9 @@ void GCMemoryAllocator::selectRelocationSet(ConcurrentLinkedList<std::shared_ptr
     while (iterator->MoveNext()) {
         std::shared_ptr<GCRegion> region = iterator->current();
         if (region != nullptr && !region->isEvacuated()) {
-            if (region.use_count() <= 2 || region->needEvacuate() &&
-                (GCParameter::doNotRelocatePtrGuard ? region->zero_use_count() : true)) {
+            bool stack_pinned = region->testAndClearStackPinned();
+            bool kept_in_place = region->testAndClearKeptInPlace();
+            if (!stack_pinned && !kept_in_place && shouldEvacuate(region, 2) && withinEvacuationReserve(region.get())) {
                 region->setEvacuated();
                 this->evacuationQue.emplace_back(std::move(region));
                 iterator->remove();
@@ -527,6 +646,87 @@ void GCMemoryAllocator::selectClearSet(ConcurrentLinkedList<std::shared_ptr<GCRe
     }
 }
 
+bool GCMemoryAllocator::shouldEvacuate(const std::shared_ptr<GCRegion>& region, long empty_use_count) const {
+    if (region.use_count() <= empty_use_count) return true;
+    return (compacting || region->needEvacuate()) &&
+           (GCParameter::doNotRelocatePtrGuard ? region->zero_use_count() : true);
+}
+
+bool GCMemoryAllocator::withinEvacuationReserve(GCRegion* region) {
+    if constexpr (GCParameter::evacuationReserveSize == 0) return true;
+    size_t live_size = region->getLiveSize();
+    if (live_size == 0) return true;        // 没有存活对象，转移时无需目标空间
+    // 每个GC线程和应用线程各自有未填满的目标region，留出其余量后再按存活字节数计入
+    constexpr size_t headroom = GCParameter::evacuationReserveSize / 4;
+    if (evacuation_reserve_selected + live_size > GCParameter::evacuationReserveSize - headroom) {
+        evacuation_deferred_regions++;
+        return false;
+    }
+    evacuation_reserve_selected += live_size;
+    return true;
+}
+
+bool GCMemoryAllocator::chargeEvacuationReserve(size_t size) {
+    if constexpr (GCParameter::evacuationReserveSize == 0) return true;
+    size_t used = evacuation_reserve_used.fetch_add(size) + size;
+    if (used <= GCParameter::evacuationReserveSize) return true;
+    evacuation_reserve_used.fetch_sub(size);
+    return false;
+}
+
+void GCMemoryAllocator::releaseEvacuationReserve(size_t size) {
+    if constexpr (GCParameter::evacuationReserveSize == 0) return;
+    evacuation_reserve_used.fetch_sub(size);
+}
+
+void GCMemoryAllocator::keepFailedEvacuations() {
+    auto failed_begin = std::stable_partition(evacuationQue.begin(), evacuationQue.end(),
+                                              [](const std::shared_ptr<GCRegion>& region) { return !region->evacuationFailed(); });
+    if (failed_begin == evacuationQue.end()) return;
+    size_t failed_count = evacuationQue.end() - failed_begin;
+    evacuation_failed_regions = failed_count;
+    for (auto it = failed_begin; it != evacuationQue.end(); ++it) {
+        std::shared_ptr<GCRegion>& region = *it;
+        region->keepInPlace();
+        {
+            std::unique_lock<std::shared_mutex> lock(regionMapMtx);
+            regionMap.emplace(region->getStartAddr(), region.get());
+        }
+        switch (region->getRegionType()) {
+            case RegionEnum::SMALL:
+                if constexpr (useConcurrentLinkedList) {
+                    smallRegionLists[getPoolIdx()].push_head(region);
+                } else {
+                    int pool_idx = getPoolIdx();
+                    std::unique_lock<std::shared_mutex> lock(smallRegionQueMtxs[pool_idx]);
+                    smallRegionQues[pool_idx].emplace_back(region);
+                }
+                break;
+            case RegionEnum::MEDIUM:
+                if constexpr (useConcurrentLinkedList) {
+                    mediumRegionList.push_head(region);
+                } else {
+                    std::unique_lock<std::shared_mutex> lock(mediumRegionQueMtx);
+                    mediumRegionQue.emplace_back(region);
+                }
+                break;
+            case RegionEnum::TINY:
+                if constexpr (useConcurrentLinkedList) {
+                    tinyRegionList.push_head(region);
+                } else {
+                    std::unique_lock<std::shared_mutex> lock(tinyRegionQueMtx);
+                    tinyRegionQue.emplace_back(region);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    evacuationQue.erase(failed_begin, evacuationQue.end());
+    std::clog << "Warning: Evacuation reserve exhausted, " << failed_count
+              << " regions failed to evacuate and are kept in place" << std::endl;
+}
+
 void GCMemoryAllocator::removeEvacuatedRegionMap() {
     std::unique_lock<std::shared_mutex> lock(regionMapMtx);
     for (auto& region : this->evacuationQue) {
@@ -560,24 +760,16 @@ void GCMemoryAllocator::clearFreeRegion(std::deque<std::shared_ptr<GCRegion>>& r
                 }
             }
         } else {
-            size_t snum = regionQue.size() / gcThreadCount;
-            for (int tid = 0; tid < gcThreadCount; tid++) {
-                threadPool->execute([this, tid, snum, &regionQue] {
-                    size_t startIndex = tid * snum;
-                    size_t endIndex = (tid == gcThreadCount - 1) ? regionQue.size() : (tid + 1) * snum;
-                    for (size_t j = startIndex; j < endIndex; j++) {
-                        GCRegion* region = regionQue[j].get();
-                        if (region->canFree()) {
-                            {
-                                std::unique_lock<std::shared_mutex> lock2(regionMapMtx);
-                                regionMap.erase(region->getStartAddr());
-                            }
-                            region->free();
-                        }
+            GCUtil::parallel_for(threadPool, getWorkerCount(regionQue.size()), regionQue.size(), [this, &regionQue](size_t j) {
+                GCRegion* region = regionQue[j].get();
+                if (region->canFree()) {
+                    {
+                        std::unique_lock<std::shared_mutex> lock2(regionMapMtx);
+                        regionMap.erase(region->getStartAddr());
                     }
-                });
-            }
-            threadPool->waitForTaskComplete(gcThreadCount);
+                    region->free();
+                }
+            });
         }
     }
     {
@@ -634,17 +826,9 @@ void GCMemoryAllocator::resetLiveSize() {
                         region->resetLiveSize();
                     }
                 } else {
-                    size_t snum = smallRegionQues[i].size() / gcThreadCount;
-                    for (int tid = 0; tid < gcThreadCount; tid++) {
-                        threadPool->execute([this, i, tid, snum] {
-                            size_t startIndex = tid * snum;
-                            size_t endIndex = (tid == gcThreadCount - 1) ? smallRegionQues[i].size() : (tid + 1) * snum;
-                            for (size_t j = startIndex; j < endIndex; j++) {
-                                smallRegionQues[i][j]->resetLiveSize();
-                            }
-                        });
-                    }
-                    threadPool->waitForTaskComplete(gcThreadCount);
+                    GCUtil::parallel_for(threadPool, getWorkerCount(smallRegionQues[i].size()), smallRegionQues[i].size(), [this, i](size_t j) {
+                        smallRegionQues[i][j]->resetLiveSize();
+                    });
                 }
             }
         }
@@ -683,6 +867,15 @@ bool GCMemoryAllocator::inside_allocated_regions(void* object_addr) {
     }
 }
 
+void GCMemoryAllocator::getRegionMapSnapshot(std::vector<std::pair<void*, GCRegion*>>& snapshot) {
+    // 按起始地址有序输出，供保守式栈扫描在不持锁的情况下二分查找
+    snapshot.clear();
+    std::shared_lock<std::shared_mutex> lock(this->regionMapMtx);
+    snapshot.reserve(regionMap.size());
+    for (auto& it : regionMap)
+        snapshot.emplace_back(it.first, it.second);
+}
+
 void GCMemoryAllocator::flushRegionMapBuffer() {
     // 将缓冲区中的内容添加回regionMap
     for (int i = 0; i < poolCount; i++) {
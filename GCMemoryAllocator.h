@@ -2,6 +2,7 @@
 #define CPPGCPTR_GCREGIONALLOCATOR_H
 
 #include <vector>
+#include <algorithm>
 #include <deque>
 #include <unordered_set>
 #include <map>
@@ -52,24 +53,53 @@ private:
 // #endif
     static thread_local std::shared_ptr<GCRegion> smallAllocatingRegion;
     static thread_local std::shared_ptr<GCRegion> smallRelocatingRegion;
+    static thread_local std::shared_ptr<GCRegion> smallLeafAllocatingRegion;
+    static thread_local std::shared_ptr<GCRegion> smallLeafRelocatingRegion;
+    static thread_local std::shared_ptr<GCRegion> smallHotRelocatingRegion;
+    static thread_local std::shared_ptr<GCRegion> smallLeafHotRelocatingRegion;
     std::atomic<std::shared_ptr<GCRegion>> mediumAllocatingRegion;
+    std::atomic<std::shared_ptr<GCRegion>> mediumLeafAllocatingRegion;
     std::atomic<std::shared_ptr<GCRegion>> tinyAllocatingRegion;
 
     std::vector<std::shared_ptr<GCRegion>> evacuationQue;
+    // 转移预留空间：选择转移集合时已计入的存活字节数、因预留空间不足本轮未转移的region数、转移失败被原地保留的region数，以及转移时已新申请的目标region字节数
+    bool compacting;                        // 本轮为gc::compact()发起的整理，转移集合包含所有可转移的region
+    size_t evacuation_reserve_selected;
+    size_t evacuation_deferred_regions;
+    size_t evacuation_failed_regions;
+    std::atomic<size_t> evacuation_reserve_used;
     std::vector<std::shared_ptr<GCRegion>> clearQue;
     std::vector<GCRegion*> liveQue;
     // 用于判定gc root，是否在被管理区域内的红黑树
     std::map<void*, GCRegion*> regionMap;
+    // 增量式回收的进度
+    bool incremental_relocation;
+    int incremental_sweep_stage;
+    size_t incremental_sweep_cursor;
+    unsigned int incremental_sweep_que;     // 清除垃圾对象时当前遍历的region队列：小于poolCount为小region队列，poolCount为中region队列，poolCount + 1为迷你region队列
     std::shared_mutex regionMapMtx;
     std::vector<std::vector<GCRegion*>> regionMapBuffer0, regionMapBuffer1;
     std::unique_ptr<std::mutex[]> regionMapBufMtx0, regionMapBufMtx1;
 
     std::pair<void*, std::shared_ptr<GCRegion>>
-        allocate_from_region(size_t size, RegionEnum regionType, bool relocate = false);
+        allocate_from_region(size_t size, RegionEnum regionType, bool relocate = false, bool leaf = false, bool run = false,
+                             bool hot = false);
 
-    void* allocate_new_memory(size_t size);
+    // relocate为true时为转移申请内存，申请失败时返回nullptr而不是反复重试
+    void* allocate_new_memory(size_t size, bool relocate = false);
 
-    void* allocate_from_freelist(size_t size);
+    void* allocate_from_freelist(size_t size, bool relocate = false);
+
+    // 选择转移集合时判断region的存活对象能否放入转移预留空间，能则计入
+    bool withinEvacuationReserve(GCRegion* region);
+
+    // 转移时为新的目标region占用预留空间，预留空间不足时返回false
+    bool chargeEvacuationReserve(size_t size);
+
+    void releaseEvacuationReserve(size_t size);
+
+    // 将转移失败的region从evacuationQue中取出，原地保留并放回region队列和红黑树
+    void keepFailedEvacuations();
 
     void clearFreeRegion(std::deque<std::shared_ptr<GCRegion>>&, std::shared_mutex&);
 
@@ -79,6 +109,9 @@ private:
 
     void selectRelocationSet(ConcurrentLinkedList<std::shared_ptr<GCRegion>>&);
 
+    // region是否选入转移集合：没有被引用的region总是选入；否则须没有PtrGuard引用，且需要转移或本轮为整理
+    bool shouldEvacuate(const std::shared_ptr<GCRegion>& region, long empty_use_count) const;
+
     void selectClearSet(std::deque<std::shared_ptr<GCRegion>>&, std::shared_mutex&);
 
     void selectClearSet(ConcurrentLinkedList<std::shared_ptr<GCRegion>>&);
@@ -89,8 +122,15 @@ private:
 
     void processClearQue();
 
+    bool clearUnmarkedStep();
+
     int getPoolIdx() const;
 
+    // 按region数量决定参与并行清扫/转移的GC线程数
+    int getWorkerCount(size_t regions) const {
+        return GCUtil::getWorkerCount(regions, GCParameter::minRegionsPerGCThread, static_cast<int>(gcThreadCount));
+    }
+
     GCRegion* queryRegionMap(void*);
 
 public:
@@ -101,26 +141,47 @@ public:
 
     GCMemoryAllocator(GCMemoryAllocator&&) noexcept = delete;
 
-    std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t size) override;
+    std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t size, bool leaf = false) override;
 
-    std::pair<void*, std::shared_ptr<GCRegion>> relocate(size_t size) override;
+    std::pair<void*, std::shared_ptr<GCRegion>> relocate(size_t size, bool leaf = false, bool hot = false) override;
+
+    std::pair<void*, std::shared_ptr<GCRegion>> relocateRun(size_t size, RegionEnum regionType, bool leaf = false) override;
 
     void* allocate_raw(size_t) override;
 
     void free(void*, size_t) override;
 
+    // 设置并行清扫/转移时最多使用的GC线程数，不超过创建时的线程池大小
+    void setGCThreadCount(int count) {
+        gcThreadCount = count;
+    }
+
     void triggerRelocation();
 
     void triggerClear();
 
-    void SelectRelocationSet();
+    // 本轮受转移预留空间限制而未能转移的region数，包括未选入转移集合的和转移失败被原地保留的
+    size_t getEvacuationLeftRegions() const {
+        return evacuation_deferred_regions + evacuation_failed_regions;
+    }
+
+    // compact为true时选入所有未被固定的region，并按存活字节数从多到少依次单线程转移，使存活对象集中到尽量少的目标region中
+    void SelectRelocationSet(bool compact = false);
 
     void SelectClearSet();
 
+    // 增量式回收：将triggerRelocation()或triggerClear()拆分为以region为单位的小任务，
+    // 每次调用incrementalSweepStep()只执行一个任务，全部完成后返回false
+    void beginIncrementalSweep(bool relocation);
+
+    bool incrementalSweepStep();
+
     void resetLiveSize();
 
     bool inside_allocated_regions(void*);
 
+    void getRegionMapSnapshot(std::vector<std::pair<void*, GCRegion*>>&);
+
     void flushRegionMapBuffer();
 
     void freeReservedMemory();
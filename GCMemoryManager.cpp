@@ -107,17 +107,14 @@ void GCMemoryManager::add_memory(size_t size) {
         std::clog << "Warning: GCMemoryManager fails to allocate more memory from OS." << std::endl;
         return;
     }
-    std::unique_lock<std::recursive_mutex> lock(this->allocate_mutex_, std::defer_lock);
-    if constexpr (GCParameter::recordNewMemMap) {
-        lock.lock();
-        new_mem_map.emplace(new_memory, malloc_size);
-    }
+    // 记录每次向操作系统申请的内存，return_reserved()据此将整块空闲的内存归还给操作系统
+    std::unique_lock<std::recursive_mutex> lock(this->allocate_mutex_);
+    new_mem_map.emplace(new_memory, malloc_size);
     this->free(new_memory, malloc_size);
     std::clog << "Info: GCMemoryManager allocated " << malloc_size << " bytes from OS." << std::endl;
 }
 
 void GCMemoryManager::return_reserved() {
-    if constexpr (!GCParameter::recordNewMemMap) return;
     std::unique_lock<std::recursive_mutex> lock(this->allocate_mutex_);
     constexpr bool check_merge = false;
     if constexpr (check_merge) {
@@ -24,11 +24,26 @@ public:
 	static constexpr bool enablePtrRWLock = false;				// 启用针对GCPtr的读写锁，启用该选项可以使GCPtr变得线程安全，无此需求请禁用
 	static constexpr bool waitingForGCFinished = false;			// 完全Stop-the-world的GC，若遇上线程安全问题，可启用此选项进行debug，否则请禁用
 	static constexpr bool zeroCountCondition = false;			// 当需要转移的region存在PtrGuard时，GC线程会休眠直到计数归零，在PtrGuard较多时可以减少GC线程的自旋消耗的CPU，但会增加应用线程每次取出指针的性能消耗
-	static constexpr bool recordNewMemMap = false;				// 是否在分配新内存时记录其起始位置和大小，用于二级内存池释放预留内存用，没什么用，不建议启用；前提条件：启用二级内存分配器，启用释放预留内存
 	static constexpr bool bitmapMemoryFromSecondary = true;		// 位图的内存是否从二级分配器分配；启用该选项可以加快位图的内存分配，但可能会导致二级分配器的内存碎片；前提条件：启用二级内存分配器
 	static constexpr bool fillZeroForNewRegion = false;			// 是否对新region的内存进行清零填充。启用此选项可缓解因用户线程未对类成员变量或内存进行初始化造成的崩溃；前提条件：启用内存分配器
 	static constexpr bool useGCPtrSet = false;					// 是否启用记录所有GCPtr的集合。启用此选项可缓解用户线程未对类的成员变量或内存进行初始化造成的崩溃，这会导致较大的性能下降；前提条件：启用析构函数
 	static constexpr bool useArrayAsRootSet = true;				// 是否使用数组而不是哈希表作为根集合，可减少约10%的性能损耗（实验特性，详见GCRootset.h的实现）；前提条件：启用内存分配器
+	static constexpr bool useThreadLocalRootSet = true;			// 是否为每个线程分配独立的根集合分段，GCPtr加入/移出根集合时无需加全局锁，标记根时逐线程握手获取快照（详见GCThreadRootSet.h的实现）；前提条件：使用数组作为根集合
+	static constexpr bool useConservativeStackScan = false;		// 是否以保守式扫描线程栈代替栈上GCPtr加入根集合，可省去栈上GCPtr构造和析构时增删根集合的开销，被线程栈引用的region当轮不会重定位（实验特性，详见GCStackScanner.h的实现）；前提条件：启用内存分配器，不使用局部哈希表
+	static constexpr bool useSIMDIdentifierScan = true;			// 标记时是否使用SIMD查找对象内GCPtr的标识头，x86-64下按CPU支持情况自动选择SSE2/AVX2/AVX-512，其它平台退化为逐字比较
+	static constexpr bool enableMarkPrefetch = true;				// 标记时是否以显式标记栈代替递归，并经由一个先进先出的预取队列提前预取对象头和位图，可减少随机链接的大堆上标记时的缓存未命中；前提条件：启用内存分配器
+	static constexpr bool useLiveBytesCache = true;				// 标记时是否将region的存活字节数先累加到标记线程私有的缓存中，标记结束后再统一汇总，避免并行标记同一region时争用其原子计数器（详见LiveBytesCache.h的实现）
+	static constexpr bool enableSATBPreClean = true;				// 是否在进入重标记前，于并发标记阶段反复处理已积累的SATB，使重标记的STW中只需处理少量剩余；前提条件：启用并发标记，启用内存分配器
+	static constexpr bool enableIncrementalGC = false;				// 未启用并发GC时，是否改为增量式GC：gc::triggerGC()只开始新一轮GC，由gc::step()分片推进标记、转移和清扫，每次停顿有上界；前提条件：禁用并发GC，启用内存分配器
+	static constexpr bool incrementalStepOnAllocation = true;		// 增量式GC进行中时，是否在每次make_gc后推进一步；前提条件：启用增量式GC
+	static constexpr bool enableLeafRegion = true;				// 是否将不含GCPtr的对象（gc::is_leaf<T>为true，小于GCPtr的类型自动判定）分配到独立的叶子region中，标记时只设置标记位而不读取对象内容；前提条件：启用内存分配器
+	static constexpr bool enableChunkedObjectScan = true;		// 并行标记时，是否将超过largeObjectScanChunkSize的大对象切分为多个扫描块放入共享队列，由多个标记线程同时扫描同一对象；前提条件：启用并行GC
+	static constexpr bool enableMarkAssist = true;				// 并发标记期间，是否让分配内存的应用线程按分配量协助标记（领取根快照、扫描块及SATB进行标记），使标记在分配高峰下仍能按时完成；前提条件：启用并发GC，启用内存分配器
+	static constexpr bool adaptiveGCThreadCount = true;			// 是否在运行时决定GC线程数：线程池按可用CPU数（考虑CPU亲和性及Linux cgroup配额）创建，各阶段再按工作量（region数、根数、SATB数）决定实际参与的线程数；若禁用则固定使用gcThreadCount个线程
+	static constexpr bool enableFinalizerThread = false;			// 是否将死亡对象的析构函数交给独立的终结器线程，在GC周期之外批量执行，含待终结对象的region在析构函数执行完毕后才归还内存（详见GCFinalizer.h的实现）；前提条件：启用析构函数，启用内存分配器
+	static constexpr bool enableCoalescedRelocation = true;		// 转移时是否将首尾相接的存活对象攒成一段整体转移，只预留一次目标空间、复制一次并记录一条转发区间，代替逐个对象的分配、复制和转发表插入；前提条件：启用重分配，未启用移动构造函数
+	static constexpr bool enableDepthFirstEvacuation = false;	// 转移时是否按引用关系深度优先转移对象，使相互引用的对象（如链表、树的相邻结点）在目标region中相邻，提升之后遍历时的缓存命中率，但会失去整段转移；前提条件：启用重分配
+	static constexpr bool enableHotColdRelocation = false;		// 转移时是否按应用线程的访问情况冷热分离：PtrGuard创建时抽样记录被访问的对象，被抽中或由应用线程自行转移的对象转移到专门的热region，其余对象转移到冷region，使热数据紧凑排列以缩小工作集；前提条件：启用重分配
 	static constexpr size_t secondaryMallocSize = 8 * 1024 * 1024;		// 二级内存分配器单次向操作系统请求分配预留内存的大小（默认：8MB）
 	static constexpr size_t TINY_OBJECT_THRESHOLD = 24;					// 迷你对象的对象大小上限（默认：24字节）
 	static constexpr size_t TINY_REGION_SIZE = 256 * 1024;				// 迷你对象的区域大小（默认：256KB）
@@ -36,7 +51,32 @@ public:
 	static constexpr size_t SMALL_REGION_SIZE = 2 * 1024 * 1024;		// 小对象的区域大小（默认：2MB）
 	static constexpr size_t MEDIUM_OBJECT_THRESHOLD = 1 * 1024 * 1024;	// 中对象的对象大小上限（默认：1MB）
 	static constexpr size_t MEDIUM_REGION_SIZE = 32 * 1024 * 1024;		// 中对象的区域大小（默认：32MB）
-	static constexpr int gcThreadCount = 4;								// GC线程数量；前提条件：启用多线程垃圾回收
+	static constexpr int useCountStripes = 8;							// region的PtrGuard引用计数的分条数量，每条独占一个缓存行，多线程同时解引用同一region内的对象时可避免缓存行争用；设为1即退化为单一计数器
+	static constexpr int markPrefetchDistance = 8;						// 标记预取队列的长度，即发出预取后再经过多少个对象才真正处理该对象；前提条件：启用标记预取
+	static constexpr size_t liveBytesCacheSize = 1024;					// 每个标记线程的存活字节数缓存的项数，须为2的幂；前提条件：启用存活字节数缓存
+	static constexpr size_t rootSnapshotChunkSize = 1024;					// 初始标记时每次持有根集合锁（或与线程根集合分段握手）最多处理的根数量，块之间释放锁，使应用线程被阻塞的时间有上界
+	static constexpr size_t satbPreCleanThreshold = 1024;					// SATB并发预清理的停止阈值，剩余的SATB不超过该数量时停止预清理，交由重标记处理；前提条件：启用SATB并发预清理
+	static constexpr int satbPreCleanMaxRounds = 8;						// SATB并发预清理的最大轮数，防止应用线程持续大量修改指针时预清理无法结束；前提条件：启用SATB并发预清理
+	static constexpr int incrementalAllocationStepBudget = 100;			// 分配时推进增量式GC的时间预算（微秒）；前提条件：启用增量式GC，启用分配时推进
+	static constexpr size_t largeObjectScanChunkSize = 128 * 1024;		// 并行标记时大对象的扫描块大小，超过该大小的对象会被切分扫描（默认：128KB），须为指针大小的整数倍
+	static constexpr size_t markAssistThreshold = 64 * 1024;			// 协助标记的欠账阈值，应用线程的欠账累计超过该值才开始协助，避免每次分配都领取根（默认：64KB）
+	static constexpr size_t markAssistMaxDebt = 4 * 1024 * 1024;		// 协助标记的欠账上限，暂时无标记工作可领取而欠账超过该值时，应用线程等待至领到工作或本轮并发标记结束（默认：4MB）
+	static constexpr int gcCpuSliceMicros = 2000;						// 启用GC的CPU预算时，GC线程连续工作多久（微秒）后按预算休眠一次（默认：2ms）
+	static constexpr size_t gcBudgetHeapGrowthLimit = 256 * 1024 * 1024;	// 一轮GC期间新申请的region超过该大小时，本轮不再按CPU预算限流，以限制堆的增长（默认：256MB）
+	static constexpr int gcThreadCount = 4;								// GC线程数量；前提条件：启用多线程垃圾回收，未启用adaptiveGCThreadCount
+	static constexpr size_t minRegionsPerGCThread = 4;					// 启用adaptiveGCThreadCount时，清扫、转移阶段每个GC线程至少分到的region数
+	static constexpr size_t minObjectsPerGCThread = 2048;				// 启用adaptiveGCThreadCount时，标记阶段每个GC线程至少分到的根或SATB数
+	static constexpr size_t finalizerBacklogWarningThreshold = 1024 * 1024;	// 待终结对象的积压数超过该值时输出提示；前提条件：启用终结器线程
+	static constexpr size_t relocationRunMaxSize = 64 * 1024;			// 整段转移时一段的最大字节数，须小于小对象的区域大小（默认：64KB）；前提条件：启用整段转移
+	static constexpr size_t relocationNonTemporalThreshold = 32 * 1024;	// 整段转移时不小于该大小的段使用非临时存储复制，仅x86-64有效（默认：32KB）；前提条件：启用整段转移
+	static constexpr size_t evacuationReserveSize = 64 * 1024 * 1024;	// 转移预留空间，一轮转移最多为目标region新申请的字节数，转移集合中的存活字节数也以此为限，超出时转移失败的region原地保留；0表示不限制（默认：64MB）；前提条件：启用重分配
+	static constexpr size_t accessSampleInterval = 16;					// 冷热分离时每个线程每创建多少个PtrGuard抽样记录一次访问（默认：16）；前提条件：启用冷热分离
 	static constexpr float evacuateFragmentRatio = 0.25;				// 当某region的碎片占比大于等于该阈值将被加入转移集合
 	static constexpr float evacuateFreeRatio = 0.25;					// 当某region的空闲空间占比小于该阈值将被加入转移集合
-};
\ No newline at end of file
+	static constexpr float markAssistRatio = 1.0;						// 协助标记的比例，应用线程每分配1字节需偿还的标记字节数
+	static constexpr float gcCpuBudget = 1.0;							// GC线程的CPU预算，即每个GC线程工作时间的最大占比，小于1时在标记和转移循环中按占空比休眠，把CPU让给应用线程（默认：1，即不限制）
+};
+
+// 局部哈希表无法由任意地址找到所在对象，保守式栈扫描会静默丢弃栈上的根
+static_assert(!GCParameter::useConservativeStackScan || (!GCParameter::useRegionalHashmap && GCParameter::enableMemoryAllocator),
+              "useConservativeStackScan requires enableMemoryAllocator and disabled useRegionalHashmap");
\ No newline at end of file
@@ -5,18 +5,30 @@
 #include <memory>
 #include <unordered_map>
 #include <atomic>
+#include <type_traits>
+#include <new>
 #include "GCPtrBase.h"
 #include "PtrGuard.h"
+#include "PinScope.h"
+#include "RootFrame.h"
 #include "GCWorker.h"
+#include "GCTypeDescriptor.h"
 
 #define ENABLE_FREE_RESERVED 0
 
+namespace gc {
+    template<typename T>
+    GCTypeRegistry::TypeId type_id();
+}
+
 template<typename T>
 class GCPtr_ : public GCPtrBase {
     template<typename U>
     friend
     class GCPtr_;
 
+    friend class gc::PinScope;
+
 protected:
     T* obj;
     unsigned int obj_size;
@@ -124,6 +136,13 @@ public:
         return ObjectInfo{obj_addr, obj_size, region};
     }
 
+    ObjectInfo getRawObjectInfo() override {
+        if (ptrLock != nullptr) ptrLock->lockRead();
+        ObjectInfo objectInfo{this->obj, this->obj_size, this->region.get()};
+        if (ptrLock != nullptr) ptrLock->unlockRead();
+        return objectInfo;
+    }
+
     GCPtr_& operator=(const GCPtr_& other) {
         if (this != &other) {
             if (this->obj != nullptr && this->obj != other.obj
@@ -211,7 +230,8 @@ public:
     }
 
     ~GCPtr_() override {
-        if (GCPhase::getGCPhase() == eGCPhase::CONCURRENT_MARK && this->obj != nullptr) {
+        // 终结器线程析构的是死亡对象，其中的GCPtr无需经过删除屏障
+        if (GCPhase::getGCPhase() == eGCPhase::CONCURRENT_MARK && this->obj != nullptr && !GCFinalizer::isFinalizing()) {
             GCPhase::EnterCriticalSection();
             GCWorker::getWorker()->addSATB(this->getObjectInfo());
             GCPhase::LeaveCriticalSection();
@@ -257,17 +277,10 @@ public:
             this->ptrLock->unlockWrite();
         if (obj == nullptr) return;
         GCWorker::getWorker()->registerObject(obj, sizeof(*obj));
-        if (GCWorker::getWorker()->destructorEnabled()) {
-            GCWorker::getWorker()->registerDestructor(obj,
-                                                      [](void* self) { static_cast<T*>(self)->~T(); },
-                                                      region.get());
-        }
-        if (GCParameter::enableMoveConstructor && region != nullptr) {
-            region->registerMoveConstructor(obj,
-                                            [](void* source_addr, void* target_addr) {
-                T* target = static_cast<T*>(target_addr);
-                new(target) T(std::move(*static_cast<T*>(source_addr)));
-            });
+        // 只需登记类型编号；平凡析构的类型在未启用移动构造函数时无需登记
+        if constexpr (!std::is_trivially_destructible_v<T> || GCParameter::enableMoveConstructor) {
+            if (GCWorker::getWorker()->destructorEnabled() || (GCParameter::enableMoveConstructor && region != nullptr))
+                GCWorker::getWorker()->registerType(obj, gc::type_id<T>(), region.get());
         }
     }
 };
@@ -278,9 +291,10 @@ public:
     using GCPtr_<void>::GCPtr_;
     using GCPtr_<void>::operator=;
 
+    // type_id由gc::type_id<T>()获得，为GCTypeRegistry::NO_TYPE时不调用析构函数
     void set(void* obj, unsigned int obj_size,
              const std::shared_ptr<GCRegion>& region = nullptr,
-             const std::function<void(void*)>& destructor = nullptr) {
+             GCTypeRegistry::TypeId type_id = GCTypeRegistry::NO_TYPE) {
         if (ptrLock != nullptr) ptrLock->lockWrite();
         this->obj = obj;
         this->obj_size = obj_size;
@@ -288,61 +302,125 @@ public:
         if (ptrLock != nullptr) ptrLock->unlockWrite();
         if (obj == nullptr) return;
         GCWorker::getWorker()->registerObject(obj, obj_size);
-        if (GCWorker::getWorker()->destructorEnabled() && destructor != nullptr) {
-            GCWorker::getWorker()->registerDestructor(obj,
-                                                      destructor,
-                                                      region.get());
+        if (GCWorker::getWorker()->destructorEnabled() && type_id != GCTypeRegistry::NO_TYPE) {
+            GCWorker::getWorker()->registerType(obj, type_id, region.get());
         }
     }
 };
 
 namespace gc {
+    // 对象内不含GCPtr时为true，此类对象分配到叶子region中，标记时只设置标记位而不扫描对象内容
+    // 小于一个GCPtr的类型必然不含GCPtr，自动视为叶子；其它不含GCPtr的类型可由用户特化，如：
+    // template<> struct gc::is_leaf<MyType> : std::true_type {};
+    // 注意：误将含有GCPtr的类型特化为叶子会导致其引用的对象被错误回收
+    template<typename T>
+    struct is_leaf : std::bool_constant<(sizeof(T) < sizeof(GCPtr<int>))> {
+    };
+
+    template<typename T>
+    inline constexpr bool is_leaf_v = is_leaf<T>::value;
+
+    template<typename T>
+    GCTypeDescriptor make_type_descriptor() {
+        GCTypeDescriptor descriptor{sizeof(T), nullptr, nullptr, std::is_trivially_destructible_v<T>, is_leaf_v<T>};
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            descriptor.destructor = [](void* self) { static_cast<T*>(self)->~T(); };
+        if constexpr (GCParameter::enableMoveConstructor) {
+            descriptor.move_constructor = [](void* source_addr, void* target_addr) {
+                new(target_addr) T(std::move(*static_cast<T*>(source_addr)));
+            };
+        }
+        return descriptor;
+    }
+
+    // 类型T的编号，首次调用时创建并登记其类型描述符
+    template<typename T>
+    GCTypeRegistry::TypeId type_id() {
+        static const GCTypeDescriptor descriptor = make_type_descriptor<T>();
+        static const GCTypeRegistry::TypeId id = GCTypeRegistry::registerType(&descriptor);
+        return id;
+    }
+
     template<class T, class... Args>
     GCPtr<T> make_gc(Args&& ... args) {
         GCPtr<T> gcptr;
+        GCWorker::allocation_depth++;
         GCPhase::EnterCriticalSection();
         T* obj = nullptr;
         std::shared_ptr<GCRegion> region = nullptr;
         if (GCWorker::getWorker()->memoryAllocatorEnabled()) {
-            auto pair = GCWorker::getWorker()->allocate(sizeof(T));
+            auto pair = GCWorker::getWorker()->allocate(sizeof(T), is_leaf_v<T>);
             obj = static_cast<T*>(pair.first);
             region = pair.second;
+            if (obj == nullptr) {
+                // 无法申请到内存，不可在空地址上构造对象
+                GCPhase::LeaveCriticalSection();
+                GCWorker::allocation_depth--;
+                throw std::bad_alloc();
+            }
             new(obj) T(std::forward<Args>(args)...);
         } else {
             obj = new T(std::forward<Args>(args)...);
         }
         gcptr.set(obj, region);
         GCPhase::LeaveCriticalSection();
+        GCWorker::allocation_depth--;
 
-        if (obj == nullptr) throw std::exception();
+        GCWorker::getWorker()->stepOnAllocation();
         return gcptr;
     }
 
     template<class T, class... Args>
     GCPtr<T> make_static(Args&& ... args) {
         GCPtr<T> gcptr(true);
+        GCWorker::allocation_depth++;
         GCPhase::EnterCriticalSection();
         T* obj = nullptr;
         std::shared_ptr<GCRegion> region = nullptr;
         if (GCWorker::getWorker()->memoryAllocatorEnabled()) {
-            auto pair = GCWorker::getWorker()->allocate(sizeof(T));
+            auto pair = GCWorker::getWorker()->allocate(sizeof(T), is_leaf_v<T>);
             obj = static_cast<T*>(pair.first);
             region = pair.second;
+            if (obj == nullptr) {
+                // 无法申请到内存，不可在空地址上构造对象
+                GCPhase::LeaveCriticalSection();
+                GCWorker::allocation_depth--;
+                throw std::bad_alloc();
+            }
             new(obj) T(std::forward<Args>(args)...);
         } else {
             obj = new T(std::forward<Args>(args)...);
         }
         gcptr.set(obj, region);
         GCPhase::LeaveCriticalSection();
+        GCWorker::allocation_depth--;
 
-        if (obj == nullptr) throw std::exception();
+        GCWorker::getWorker()->stepOnAllocation();
         return gcptr;
     }
 
     void triggerGC() {
         GCWorker::getWorker()->triggerGC();
     }
+
+    // 增量式GC：推进由triggerGC()开始的这一轮GC，每次最多占用约budget的时间，GC尚未完成时返回true
+    inline bool step(std::chrono::microseconds budget) {
+        return GCWorker::getWorker()->step(budget);
+    }
     
+    // 已提交给终结器线程但尚未执行析构函数的对象数；未启用终结器线程时为0
+    inline size_t getFinalizerBacklog() {
+        GCFinalizer* finalizer = GCWorker::getWorker()->getFinalizer();
+        return finalizer == nullptr ? 0 : finalizer->getPendingCount();
+    }
+
+    // 整理堆：进行一轮完整的GC，转移所有未被固定的region，使存活对象集中到尽量少的region中，并将释放的内存归还给操作系统
+    // 阻塞直到整理完成；适合在缓存重建、流量高峰之后调用以降低常驻内存
+    // 返回受evacuationReserveSize限制而仍留在原地的region数
+    inline size_t compact() {
+        return GCWorker::getWorker()->compact();
+    }
+
 #if ENABLE_FREE_RESERVED
     void freeReservedMemory() {
         // 该函数目前仅用于二级内存池的预留内存释放
@@ -40,6 +40,9 @@ public:
 
     virtual ObjectInfo getObjectInfo() = 0;
 
+    // 不自愈，直接返回GCPtr当前保存的地址和region
+    virtual ObjectInfo getRawObjectInfo() = 0;
+
     MarkState getInlineMarkState() const {
         return inlineMarkState;
     }
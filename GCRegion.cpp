@@ -6,11 +6,18 @@ const size_t GCRegion::SMALL_OBJECT_THRESHOLD = GCParameter::SMALL_OBJECT_THRESH
 const size_t GCRegion::SMALL_REGION_SIZE = GCParameter::SMALL_REGION_SIZE;
 const size_t GCRegion::MEDIUM_OBJECT_THRESHOLD = GCParameter::MEDIUM_OBJECT_THRESHOLD;
 const size_t GCRegion::MEDIUM_REGION_SIZE = GCParameter::MEDIUM_REGION_SIZE;
+std::atomic<uint8_t> GCRegion::access_epoch{1};
+std::atomic<uint32_t> GCRegion::access_wrap{0};
+thread_local int GCRegion::access_sample_countdown = 0;
 
-GCRegion::GCRegion(RegionEnum regionType, void* startAddress, size_t total_size, IMemoryAllocator* memoryAllocator) :
-        regionType(regionType), startAddress(startAddress),
-        memoryAllocator(memoryAllocator), largeRegionMarkState(MarkStateBit::NOT_ALLOCATED),
-        total_size(total_size), allocated_offset(0), live_size(0), evacuated(false), use_count(0) {
+GCRegion::GCRegion(RegionEnum regionType, void* startAddress, size_t total_size, IMemoryAllocator* memoryAllocator,
+                   bool leaf) :
+        startAddress(startAddress), total_size(total_size), allocated_offset(0), live_size(0),
+        regionType(regionType), largeRegionMarkState(MarkStateBit::NOT_ALLOCATED), type_table(nullptr), access_table(nullptr),
+        access_table_wrap(access_wrap.load()), memoryAllocator(memoryAllocator), evacuated(false), stack_pinned(false),
+        leaf(leaf || (GCParameter::enableLeafRegion && regionType == RegionEnum::TINY)),
+        finalization_pending(GCParameter::enableFinalizerThread ? std::make_shared<std::atomic<size_t>>(0) : nullptr),
+        evacuation_failed(false), guards_drained(false), kept_in_place(false) {
     if (regionType != RegionEnum::LARGE) {
         if constexpr (!use_regional_hashmap) {
             switch (regionType) {
@@ -25,14 +32,70 @@ GCRegion::GCRegion(RegionEnum regionType, void* startAddress, size_t total_size,
         } else {
             regionalHashMap = std::make_unique<GCRegionalHashMap>();
         }
-        if constexpr (enable_destructor) {
-            destructor_map = std::make_unique<std::unordered_map<void*, std::function<void(void*)>>>();
-            destructor_map->reserve(128);
+        if constexpr (record_object_start) {
+            size_t granule_count = total_size / OBJECT_START_GRANULE;
+            object_start_map = std::make_unique<std::atomic<uint64_t>[]>((granule_count + 63) / 64);
         }
-        if constexpr (enable_move_constructor) {
-            move_constructor_map = std::make_unique<std::unordered_map<void*, std::function<void(void*, void*)>>>();
-            move_constructor_map->reserve(64);
+    }
+}
+
+size_t GCRegion::alignObjectSize(size_t size) const {
+    // 启用对象起始位置图时，小对象和中对象按8字节对齐分配，使每个对象的起始位置独占一个bit
+    if constexpr (record_object_start) {
+        if (regionType == RegionEnum::SMALL || regionType == RegionEnum::MEDIUM)
+            return (size + OBJECT_START_GRANULE - 1) / OBJECT_START_GRANULE * OBJECT_START_GRANULE;
+    }
+    return size;
+}
+
+void GCRegion::setObjectStart(void* object_addr, bool is_start) {
+    if (object_start_map == nullptr) return;
+    size_t granule = static_cast<size_t>(reinterpret_cast<char*>(object_addr) - reinterpret_cast<char*>(startAddress)) / OBJECT_START_GRANULE;
+    uint64_t mask = static_cast<uint64_t>(1) << (granule % 64);
+    if (is_start)
+        object_start_map[granule / 64].fetch_or(mask);
+    else
+        object_start_map[granule / 64].fetch_and(~mask);
+}
+
+bool GCRegion::findObjectStart(void* addr, void*& object_addr, size_t& object_size) const {
+    char* start = reinterpret_cast<char*>(startAddress);
+    size_t _allocated_offset = allocated_offset.load();
+    if (start == nullptr || reinterpret_cast<char*>(addr) < start) return false;
+    size_t offset = reinterpret_cast<char*>(addr) - start;
+    if (offset >= _allocated_offset) return false;
+    if (regionType == RegionEnum::LARGE) {
+        object_addr = start;
+        object_size = _allocated_offset;
+        return true;
+    }
+    if constexpr (use_regional_hashmap) {
+        return false;
+    } else {
+        if (object_start_map == nullptr) return false;
+        // 向前查找最近的对象起始位置，最多回溯一个中对象的大小
+        size_t granule = offset / OBJECT_START_GRANULE;
+        size_t max_backtrack = MEDIUM_OBJECT_THRESHOLD / OBJECT_START_GRANULE;
+        size_t min_granule = granule > max_backtrack ? granule - max_backtrack : 0;
+        size_t word_idx = granule / 64;
+        int bit_idx = static_cast<int>(granule % 64);
+        uint64_t word = object_start_map[word_idx].load();
+        if (bit_idx != 63) word &= (static_cast<uint64_t>(1) << (bit_idx + 1)) - 1;
+        while (word == 0) {
+            if (word_idx == 0 || word_idx * 64 <= min_granule) return false;
+            word = object_start_map[--word_idx].load();
         }
+        size_t found = word_idx * 64 + (63 - std::countl_zero(word));
+        if (found < min_granule) return false;
+        char* c_object_addr = start + found * OBJECT_START_GRANULE;
+        if (bitmap->getMarkState(c_object_addr) == MarkStateBit::NOT_ALLOCATED) return false;
+        size_t c_object_size = regionType == RegionEnum::TINY ? TINY_OBJECT_THRESHOLD : bitmap->getObjectSize(c_object_addr);
+        if (c_object_size == 0 || c_object_addr + c_object_size <= addr
+            || found * OBJECT_START_GRANULE + c_object_size > _allocated_offset)
+            return false;
+        object_addr = c_object_addr;
+        object_size = c_object_size;
+        return true;
     }
 }
 
@@ -43,6 +106,7 @@ void* GCRegion::allocate(size_t size) {
         size = TINY_OBJECT_THRESHOLD;
     else if (regionType != RegionEnum::LARGE && !use_regional_hashmap)
         size = bitmap->alignUpSize(size);
+    size = alignObjectSize(size);
     while (true) {
         size_t p_offset = allocated_offset;
         if (p_offset + size > total_size) {
@@ -53,6 +117,25 @@ void* GCRegion::allocate(size_t size) {
             break;
         }
     }
+    markAllocated(object_addr, size);
+    return object_addr;
+}
+
+void* GCRegion::allocateRun(size_t size) {
+    if (startAddress == nullptr || evacuated.load()) return nullptr;
+    while (true) {
+        size_t p_offset = allocated_offset;
+        if (p_offset + size > total_size) {
+            return nullptr;
+        }
+        if (allocated_offset.compare_exchange_weak(p_offset, p_offset + size))
+            return reinterpret_cast<char*>(startAddress) + p_offset;
+    }
+}
+
+void GCRegion::markAllocated(void* object_addr, size_t size) {
+    if constexpr (record_object_start)
+        setObjectStart(object_addr, true);
     if (GCPhase::duringGC()) {
         if constexpr (use_regional_hashmap) {
             regionalHashMap->mark(object_addr, size, GCPhase::getCurrentMarkState(), true);
@@ -68,11 +151,13 @@ void* GCRegion::allocate(size_t size) {
             bitmap->mark(object_addr, size, MarkStateBit::REMAPPED, true);
         }
     }
-    return object_addr;
 }
 
 void GCRegion::free(void* addr, size_t size) {
+    size = alignObjectSize(size);
     if (inside_region(addr, size)) {
+        if constexpr (record_object_start)
+            setObjectStart(addr, false);
         // free()要不要调用mark(addr, size, MarkStateBit::NOT_ALLOCATED)？好像还是要的
         // 现已改为mark的时候统计live_size，而不是frag_size
         bool recently_assigned;
@@ -89,7 +174,15 @@ void GCRegion::free(void* addr, size_t size) {
                 break;
             }
         }
-        if (!recently_assigned) {
+        if (recently_assigned) {
+            // 撤销的分配可能被再次分配给平凡析构的对象，须清除残留的类型编号
+            std::atomic<GCTypeRegistry::TypeId>* table = type_table.load(std::memory_order_acquire);
+            if (table != nullptr)
+                table[typeTableSlot(addr)].store(GCTypeRegistry::NO_TYPE, std::memory_order_relaxed);
+            std::atomic<uint8_t>* accesses = access_table.load(std::memory_order_acquire);
+            if (accesses != nullptr)
+                accesses[typeTableSlot(addr)].store(0, std::memory_order_relaxed);
+        } else {
             if constexpr (use_regional_hashmap) {
                 regionalHashMap->mark(addr, size, MarkState::DE_ALLOCATED, false, false);
             } else {
@@ -112,18 +205,20 @@ float GCRegion::getFreeRatio() const {
     return (float) (1.0 - (double) allocated_offset / (double) total_size);
 }
 
-void GCRegion::mark(void* object_addr, size_t object_size) {
+size_t GCRegion::mark(void* object_addr, size_t object_size) {
+    object_size = alignObjectSize(object_size);
     if (regionType == RegionEnum::LARGE) {
         this->largeRegionMarkState = GCPhase::getCurrentMarkStateBit();
     } else {
         if constexpr (use_regional_hashmap) {
             if (regionalHashMap->mark(object_addr, object_size, GCPhase::getCurrentMarkState()))
-                live_size += object_size;
+                return object_size;
         } else {
             if (bitmap->mark(object_addr, object_size, GCPhase::getCurrentMarkStateBit()))
-                live_size += object_size;
+                return object_size;
         }
     }
+    return 0;
 }
 
 bool GCRegion::marked(void* object_addr) {
@@ -138,6 +233,17 @@ bool GCRegion::marked(void* object_addr) {
     }
 }
 
+void GCRegion::prefetchForMark(void* object_addr) const {
+    if (!leaf)      // 叶子对象不会被扫描，无需预取对象内容
+        GC_PREFETCH(object_addr);
+    if (regionType != RegionEnum::LARGE) {
+        if constexpr (!use_regional_hashmap) {
+            if (bitmap != nullptr)
+                bitmap->prefetch(object_addr);
+        }
+    }
+}
+
 void GCRegion::clearUnmarked() {
     if (GCPhase::getGCPhase() != eGCPhase::SWEEP) {
         std::cerr << "Wrong phase, should in sweeping phase to trigger clearUnmarked()" << std::endl;
@@ -147,6 +253,7 @@ void GCRegion::clearUnmarked() {
         std::clog << "Large region doesn't need to trigger this function." << std::endl;
         return;
     }
+    GCFinalizer::Batch finalization_batch;
     if constexpr (use_regional_hashmap) {
         auto regionalMapIterator = regionalHashMap->getIterator();
         while (regionalMapIterator.MoveNext()) {
@@ -157,7 +264,7 @@ void GCRegion::clearUnmarked() {
                 regionalMapIterator.setCurrentMarkState(MarkState::DE_ALLOCATED);
                 if constexpr (enable_destructor) {
                     void* addr = regionalMapIterator.getCurrentAddress();
-                    callDestructor(addr);
+                    finalizeObject(addr, finalization_batch);
                 }
             }
         }
@@ -174,8 +281,10 @@ void GCRegion::clearUnmarked() {
                     // 非存活对象统一标记为REMAPPED，因为仍然需要size信息遍历bitmap，并避免markState重复
                     // 但是这似乎会导致本来就是REMAPPED的对象不会被调用析构函数，现改为标记为NOT_ALLOCATED
                     bitmap->mark(addr, bitStatus.objectSize, MarkStateBit::NOT_ALLOCATED);
+                    if constexpr (record_object_start)
+                        setObjectStart(addr, false);
                     if constexpr (enable_destructor) {
-                        callDestructor(addr);
+                        finalizeObject(addr, finalization_batch);
                     }
                 } else if (bitStatus.objectSize == 0 && regionType != RegionEnum::TINY) {
                     throw std::runtime_error("Object size found 0 in bitmap");
@@ -186,6 +295,7 @@ void GCRegion::clearUnmarked() {
             std::clog << "Info: GCRegion::clearUnmarked() caught an exception thrown by GCBitmap: " << e.what() << std::endl;
         }
     }
+    submitFinalization(finalization_batch);
 }
 
 void GCRegion::triggerRelocation() {
@@ -194,13 +304,13 @@ void GCRegion::triggerRelocation() {
         return;
     }
     if (GCParameter::zeroCountCondition) {
-        while (use_count != 0) {
+        while (!zero_use_count()) {
             std::unique_lock<std::mutex> lock(this->zero_count_mutex);
             zero_count_condition.wait(lock, [this] { return zero_use_count(); });
         }
     } else {
         int wait_cnt = 0;
-        while (use_count != 0) {
+        while (!zero_use_count()) {
             wait_cnt++;
             std::this_thread::yield();
         }
@@ -212,8 +322,10 @@ void GCRegion::triggerRelocation() {
     if (this->canFree() && !enable_destructor) {      // 已经没有存活对象了
         return;
     }
-    while (use_count != 0) std::this_thread::yield();
+    while (!zero_use_count()) std::this_thread::yield();
+    guards_drained.store(true);
 
+    GCFinalizer::Batch finalization_batch;
     if constexpr (use_regional_hashmap) {
         auto regionalMapIterator = regionalHashMap->getIterator();
         while (regionalMapIterator.MoveNext()) {
@@ -222,35 +334,70 @@ void GCRegion::triggerRelocation() {
             void* object_addr = regionalMapIterator.getCurrentAddress();
             if (GCPhase::isLiveObject(markState)) {
                 size_t object_size = regionType == RegionEnum::TINY ? TINY_OBJECT_THRESHOLD : gcStatus.objectSize;
-                this->relocateObject(object_addr, object_size);
+                if constexpr (GCParameter::enableDepthFirstEvacuation)
+                    GCWorker::getWorker()->evacuateDepthFirst(ObjectInfo{object_addr, object_size, this});
+                else
+                    this->relocateObject(object_addr, object_size);
+                GCCpuBudget::checkpoint();
             } else if (GCPhase::needSweep(markState)) {
                 if constexpr (enable_destructor) {
-                    callDestructor(object_addr);
+                    finalizeObject(object_addr, finalization_batch);
                 }
             }
         }
     } else {
+        // 首尾相接的存活对象攒成一段整体转移：只预留一次目标空间、复制一次、记录一条转发区间
+        // 调用移动构造函数、需要在GCPtrSet中逐个重新登记或按引用关系深度优先转移时只能逐个转移
+        constexpr bool coalesce = GCParameter::enableCoalescedRelocation && !enable_move_constructor && !GCParameter::useGCPtrSet
+                                  && !GCParameter::enableDepthFirstEvacuation;
+        const bool coalesce_region = coalesce && (regionType == RegionEnum::SMALL || regionType == RegionEnum::TINY);
+        std::vector<std::pair<size_t, size_t>> run;
+        size_t run_end = 0;
+        auto flush_run = [this, &run] {
+            if (run.size() == 1)
+                this->relocateObject(reinterpret_cast<char*>(startAddress) + run[0].first, run[0].second);
+            else if (run.size() > 1)
+                this->relocateRun(run);
+            run.clear();
+        };
         auto bitMapIterator = bitmap->getIterator();
         while (bitMapIterator.MoveNext() && bitMapIterator.getCurrentOffset() < allocated_offset) {
             GCBitMap::BitStatus bitStatus = bitMapIterator.current();
             MarkStateBit& markState = bitStatus.markState;
-            void* object_addr = reinterpret_cast<char*>(startAddress) + bitMapIterator.getCurrentOffset();
+            size_t offset = bitMapIterator.getCurrentOffset();
+            void* object_addr = reinterpret_cast<char*>(startAddress) + offset;
             if (GCPhase::isLiveObject(markState)) {     // 存活对象，转移
                 unsigned int object_size = regionType == RegionEnum::TINY ? TINY_OBJECT_THRESHOLD : bitStatus.objectSize;
-                this->relocateObject(object_addr, object_size);
+                if constexpr (GCParameter::enableDepthFirstEvacuation) {
+                    GCWorker::getWorker()->evacuateDepthFirst(ObjectInfo{object_addr, object_size, this});
+                } else if (!coalesce_region) {
+                    this->relocateObject(object_addr, object_size);
+                } else if (GCParameter::enableHotColdRelocation && isHot(object_addr)) {
+                    // 热对象单独转移到热region，段只由冷对象组成
+                    flush_run();
+                    this->relocateObject(object_addr, object_size);
+                } else {
+                    if (run.empty() || offset != run_end || run_end + object_size - run.front().first > GCParameter::relocationRunMaxSize)
+                        flush_run();
+                    run.emplace_back(offset, object_size);
+                    run_end = offset + object_size;
+                }
+                GCCpuBudget::checkpoint();
             } else if (GCPhase::needSweep(markState)) { // 非存活对象，调用其析构函数
                 // 由于region触发重定位后是不会再被使用的，因此无需再次标记
                 // bitmap->mark(object_addr, bitStatus.objectSize, MarkStateBit::NOT_ALLOCATED);
                 if constexpr (enable_destructor) {
-                    callDestructor(object_addr);
+                    finalizeObject(object_addr, finalization_batch);
                 }
             }
         }
+        flush_run();
     }
+    submitFinalization(finalization_batch);
 }
 
-void GCRegion::relocateObject(void* object_addr, size_t object_size) {
-    if (isFreed()) return;
+void GCRegion::relocateObject(void* object_addr, size_t object_size, bool hot) {
+    if (isFreed() || evacuation_failed.load(std::memory_order_relaxed)) return;
     if (!inside_region(object_addr, object_size)) {
         std::cerr << "Warning: The relocating object does not in current region " << object_addr << std::endl;
         return;
@@ -263,40 +410,40 @@ void GCRegion::relocateObject(void* object_addr, size_t object_size) {
     }
     {
         std::shared_lock<std::shared_mutex> lock(this->forwarding_table_mutex);
-        if (forwarding_table.contains(object_addr))      // 已经被应用线程转移了
+        std::pair<void*, std::shared_ptr<GCRegion>> forwarded;
+        if (lookupForwarding(object_addr, forwarded))      // 已经被应用线程转移了
             return;
     }
-    auto new_addr = memoryAllocator->relocate(object_size);
+    GCTypeRegistry::TypeId type_id = getTypeId(object_addr);
+    // 被抽样访问过或由应用线程自行转移的热对象转移到热region中
+    hot = GCParameter::enableHotColdRelocation && (hot || isHot(object_addr));
+    auto new_addr = memoryAllocator->relocate(object_size, leaf, hot);
+    if (new_addr.first == nullptr) {
+        // 没有可用的目标空间，放弃转移本region，剩余对象留在原地
+        evacuation_failed.store(true);
+        return;
+    }
     void* new_object_addr = new_addr.first;
     std::shared_ptr<GCRegion>& new_region = new_addr.second;
     if (!this->isFreed()) {
-        if constexpr (enable_move_constructor) {
+        const GCTypeDescriptor* descriptor = GCTypeRegistry::getDescriptor(type_id);
+        if (enable_move_constructor && descriptor != nullptr && descriptor->move_constructor != nullptr) {
             // 调用移动构造函数后立即调用析构函数析构原对象
-            callMoveConstructor(object_addr, new_object_addr);
-            callDestructor(object_addr);
+            descriptor->move_constructor(object_addr, new_object_addr);
+            if (descriptor->destructor != nullptr)
+                descriptor->destructor(object_addr);
         } else {
             ::memcpy(new_object_addr, object_addr, object_size);
         }
         // 如果在转移过程中，有应用线程访问了旧地址上的原对象并产生了写入怎么办？参考shenandoah解决方案
         std::unique_lock<std::shared_mutex> fwdtb_lock(this->forwarding_table_mutex);
-        if (!forwarding_table.contains(object_addr)) {
+        std::pair<void*, std::shared_ptr<GCRegion>> forwarded;
+        if (!lookupForwarding(object_addr, forwarded)) {
             forwarding_table.emplace(object_addr, new_addr);
             fwdtb_lock.unlock();
-            // 将析构函数和移动构造函数注册到新region中去
-            if constexpr (enable_destructor) {
-                std::shared_lock<std::shared_mutex> lock2(destructor_map_mtx);
-                auto it = destructor_map->find(object_addr);
-                if (it != destructor_map->end()) {
-                    new_region->registerDestructor(new_object_addr, it->second);
-                }
-            }
-            if constexpr (enable_move_constructor) {
-                std::shared_lock<std::shared_mutex> lock2(move_constructor_map_mtx);
-                auto it = move_constructor_map->find(object_addr);
-                if (it != move_constructor_map->end()) {
-                    new_region->registerMoveConstructor(new_object_addr, it->second);
-                }
-            }
+            // 将类型编号复制到新region中去
+            if (type_id != GCTypeRegistry::NO_TYPE)
+                new_region->setTypeId(new_object_addr, type_id);
             // 在GCPtrSet中重新注册
             if constexpr (GCParameter::useGCPtrSet && !enable_move_constructor) {
                 std::vector<GCPtrBase*> inside_set =
@@ -314,6 +461,89 @@ void GCRegion::relocateObject(void* object_addr, size_t object_size) {
     new_region->free(new_object_addr, object_size);
 }
 
+void GCRegion::relocateRun(const std::vector<std::pair<size_t, size_t>>& objects) {
+    if (isFreed() || evacuation_failed.load(std::memory_order_relaxed)) return;
+    char* run_begin = reinterpret_cast<char*>(startAddress) + objects.front().first;
+    size_t run_size = objects.back().first + objects.back().second - objects.front().first;
+    auto new_run = memoryAllocator->relocateRun(run_size, regionType, leaf);
+    if (new_run.first == nullptr) {
+        evacuation_failed.store(true);
+        return;
+    }
+    char* new_begin = static_cast<char*>(new_run.first);
+    std::shared_ptr<GCRegion>& new_region = new_run.second;
+    // 先逐个标记目标region中的对象，再整体复制
+    for (auto& [offset, size] : objects)
+        new_region->markAllocated(new_begin + (offset - objects.front().first), size);
+    if (this->isFreed()) {
+        for (auto& [offset, size] : objects)
+            new_region->free(new_begin + (offset - objects.front().first), size);
+        return;
+    }
+    GCUtil::copyMemory(new_begin, run_begin, run_size);
+    // 整段记录一条转发区间；复制期间已被应用线程单独转移的对象以其自身的转发为准，撤回其在段内的副本
+    std::vector<bool> conflicted(objects.size(), false);
+    {
+        std::unique_lock<std::shared_mutex> fwdtb_lock(this->forwarding_table_mutex);
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (forwarding_table.contains(run_begin + (objects[i].first - objects.front().first)))
+                conflicted[i] = true;
+        }
+        forwarding_ranges.push_back({run_begin, run_begin + run_size, new_begin, new_region});
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        size_t relative = objects[i].first - objects.front().first;
+        if (conflicted[i]) {
+            new_region->free(new_begin + relative, objects[i].second);
+        } else {
+            GCTypeRegistry::TypeId type_id = getTypeId(run_begin + relative);
+            if (type_id != GCTypeRegistry::NO_TYPE)
+                new_region->setTypeId(new_begin + relative, type_id);
+        }
+    }
+}
+
+bool GCRegion::lookupForwarding(void* object_addr, std::pair<void*, std::shared_ptr<GCRegion>>& result) const {
+    auto it = forwarding_table.find(object_addr);
+    if (it != forwarding_table.end()) {
+        result = it->second;
+        return true;
+    }
+    char* addr = static_cast<char*>(object_addr);
+    auto range = std::upper_bound(forwarding_ranges.begin(), forwarding_ranges.end(), addr,
+                                  [](char* p, const ForwardingRange& r) { return p < r.begin; });
+    if (range == forwarding_ranges.begin()) return false;
+    --range;
+    if (addr >= range->end) return false;
+    result = std::make_pair(range->new_begin + (addr - range->begin), range->new_region);
+    return true;
+}
+
+void GCRegion::keepInPlace() {
+    // 已转移出去的对象在原地留下的副本不再有效，清除其类型编号，使之后清扫这些副本时不会调用析构函数
+    {
+        std::unique_lock<std::shared_mutex> lock(this->forwarding_table_mutex);
+        std::atomic<GCTypeRegistry::TypeId>* table = type_table.load(std::memory_order_acquire);
+        if (table != nullptr) {
+            for (auto& entry : forwarding_table)
+                table[typeTableSlot(entry.first)].store(GCTypeRegistry::NO_TYPE, std::memory_order_relaxed);
+            for (auto& range : forwarding_ranges) {
+                for (size_t slot = typeTableSlot(range.begin); slot <= typeTableSlot(range.end - 1); slot++)
+                    table[slot].store(GCTypeRegistry::NO_TYPE, std::memory_order_relaxed);
+            }
+        }
+    }
+    kept_in_place.store(true);
+    guards_drained.store(false);
+    evacuated.store(false);
+}
+
+bool GCRegion::testAndClearKeptInPlace() {
+    if (!kept_in_place.exchange(false)) return false;
+    evacuation_failed.store(false);
+    return true;
+}
+
 bool GCRegion::canFree() const {
     if (regionType == RegionEnum::LARGE) {
         if (GCPhase::needSweep(largeRegionMarkState)) return true;
@@ -336,9 +566,17 @@ void GCRegion::free() {
     evacuated = true;
     bitmap = nullptr;
     regionalHashMap = nullptr;
-    destructor_map = nullptr;
-    move_constructor_map = nullptr;
-    memoryAllocator->free(startAddress, total_size);
+    delete[] type_table.exchange(nullptr);
+    // 持有PtrGuard的应用线程可能仍在写访问记录表，use_count归零后才可释放，否则留给析构函数释放
+    if (zero_use_count())
+        delete[] access_table.exchange(nullptr);
+    object_start_map = nullptr;
+    if (finalization_pending != nullptr && finalization_pending->load() > 0) {
+        // 本region中仍有对象等待终结器线程执行析构函数，内存排在这些析构函数之后归还
+        GCWorker::getWorker()->getFinalizer()->submitFree(memoryAllocator, startAddress, total_size);
+    } else {
+        memoryAllocator->free(startAddress, total_size);
+    }
     startAddress = nullptr;
     total_size = 0;
     allocated_offset = 0;
@@ -348,20 +586,37 @@ void GCRegion::reclaim() {
     largeRegionMarkState = MarkStateBit::REMAPPED;
     if constexpr (use_regional_hashmap)
         regionalHashMap->clear();
-    if constexpr (enable_destructor)
-        destructor_map->clear();
-    if constexpr (enable_move_constructor)
-        move_constructor_map->clear();
+    std::atomic<GCTypeRegistry::TypeId>* table = type_table.load();
+    if (table != nullptr) {
+        size_t slot_count = typeTableSlot(reinterpret_cast<char*>(startAddress) + total_size) + 1;
+        for (size_t i = 0; i < slot_count; i++)
+            table[i].store(GCTypeRegistry::NO_TYPE, std::memory_order_relaxed);
+    }
+    std::atomic<uint8_t>* accesses = access_table.load();
+    if (accesses != nullptr) {
+        size_t slot_count = typeTableSlot(reinterpret_cast<char*>(startAddress) + total_size) + 1;
+        for (size_t i = 0; i < slot_count; i++)
+            accesses[i].store(0, std::memory_order_relaxed);
+    }
+    if (object_start_map != nullptr) {
+        size_t word_count = (total_size / OBJECT_START_GRANULE + 63) / 64;
+        for (size_t i = 0; i < word_count; i++)
+            object_start_map[i].store(0, std::memory_order_relaxed);
+    }
     allocated_offset = 0;
     live_size = 0;
     evacuated = false;
 }
 
 GCRegion::GCRegion(GCRegion&& other) noexcept :
-        regionType(other.regionType), startAddress(other.startAddress), total_size(other.total_size),
+        startAddress(other.startAddress), total_size(other.total_size),
+        regionType(other.regionType), largeRegionMarkState(other.largeRegionMarkState),
         bitmap(std::move(other.bitmap)), regionalHashMap(std::move(other.regionalHashMap)),
-        memoryAllocator(other.memoryAllocator), largeRegionMarkState(other.largeRegionMarkState),
-        destructor_map(std::move(other.destructor_map)), move_constructor_map(std::move(other.move_constructor_map)) {
+        type_table(other.type_table.exchange(nullptr)), access_table(other.access_table.exchange(nullptr)),
+        access_table_wrap(other.access_table_wrap.load()), memoryAllocator(other.memoryAllocator), object_start_map(std::move(other.object_start_map)),
+        stack_pinned(other.stack_pinned.load()), leaf(other.leaf),
+        finalization_pending(std::move(other.finalization_pending)), evacuation_failed(other.evacuation_failed.load()),
+        guards_drained(other.guards_drained.load()), kept_in_place(other.kept_in_place.load()) {
     this->allocated_offset.store(other.allocated_offset.load());
     this->live_size.store(other.live_size.load());
     this->evacuated.store(other.evacuated.load());
@@ -372,41 +627,137 @@ GCRegion::GCRegion(GCRegion&& other) noexcept :
 
 std::pair<void*, std::shared_ptr<GCRegion>> GCRegion::queryForwardingTable(void* ptr) {
     std::shared_lock<std::shared_mutex> lock(this->forwarding_table_mutex);
-    auto it = forwarding_table.find(ptr);
-    if (it == forwarding_table.end()) return std::make_pair(nullptr, nullptr);
-    else return it->second;
+    std::pair<void*, std::shared_ptr<GCRegion>> result;
+    if (!lookupForwarding(ptr, result)) return std::make_pair(nullptr, nullptr);
+    return result;
 }
 
-void GCRegion::registerDestructor(void* object_addr, const std::function<void(void*)>& func) {
-    if (destructor_map == nullptr) return;
-    std::unique_lock<std::shared_mutex> lock(destructor_map_mtx);
-    destructor_map->emplace(object_addr, func);
+GCRegion::~GCRegion() {
+    delete[] type_table.load();
+    delete[] access_table.load();
 }
 
-void GCRegion::registerMoveConstructor(void* object_addr, const std::function<void(void*, void*)>& func) {
-    if (move_constructor_map == nullptr) return;
-    std::unique_lock<std::shared_mutex> lock(move_constructor_map_mtx);
-    move_constructor_map->emplace(object_addr, func);
+size_t GCRegion::typeTableSlot(void* object_addr) const {
+    // 槽位大小不超过该类region中最小的对象，因此不同对象的起始位置必然落在不同槽位
+    size_t offset = static_cast<size_t>(reinterpret_cast<char*>(object_addr) - reinterpret_cast<char*>(startAddress));
+    switch (regionType) {
+        case RegionEnum::TINY:
+        case RegionEnum::SMALL:
+            return offset / TINY_OBJECT_THRESHOLD;
+        case RegionEnum::MEDIUM:
+            return offset / SMALL_OBJECT_THRESHOLD;
+        default:
+            return 0;       // 大region中只有一个对象
+    }
 }
 
-void GCRegion::callDestructor(void* object_addr) {
-    std::shared_lock<std::shared_mutex> lock(destructor_map_mtx);
-    auto it = destructor_map->find(object_addr);
-    if (it != destructor_map->end()) {
-        auto& destructor = it->second;
-        destructor(object_addr);
+std::atomic<GCTypeRegistry::TypeId>* GCRegion::ensureTypeTable() {
+    std::atomic<GCTypeRegistry::TypeId>* table = type_table.load(std::memory_order_acquire);
+    if (table != nullptr) return table;
+    size_t slot_count = typeTableSlot(reinterpret_cast<char*>(startAddress) + total_size) + 1;
+    auto* new_table = new std::atomic<GCTypeRegistry::TypeId>[slot_count]();
+    if (type_table.compare_exchange_strong(table, new_table, std::memory_order_acq_rel))
+        return new_table;
+    delete[] new_table;     // 已被其它线程抢先创建
+    return table;
+}
+
+void GCRegion::setTypeId(void* object_addr, GCTypeRegistry::TypeId type_id) {
+    if (startAddress == nullptr) return;
+    ensureTypeTable()[typeTableSlot(object_addr)].store(type_id, std::memory_order_relaxed);
+}
+
+GCTypeRegistry::TypeId GCRegion::getTypeId(void* object_addr) const {
+    std::atomic<GCTypeRegistry::TypeId>* table = type_table.load(std::memory_order_acquire);
+    if (table == nullptr) return GCTypeRegistry::NO_TYPE;
+    return table[typeTableSlot(object_addr)].load(std::memory_order_relaxed);
+}
+
+std::atomic<uint8_t>* GCRegion::ensureAccessTable() {
+    std::atomic<uint8_t>* table = access_table.load(std::memory_order_acquire);
+    if (table != nullptr) return table;
+    size_t slot_count = typeTableSlot(reinterpret_cast<char*>(startAddress) + total_size) + 1;
+    auto* new_table = new std::atomic<uint8_t>[slot_count]();
+    if (access_table.compare_exchange_strong(table, new_table, std::memory_order_acq_rel))
+        return new_table;
+    delete[] new_table;
+    return table;
+}
+
+void GCRegion::recordAccess(const void* object_addr) {
+    if (evacuated.load(std::memory_order_relaxed) || startAddress == nullptr || !inside_region(const_cast<void*>(object_addr)))
+        return;
+    std::atomic<uint8_t>* table = ensureAccessTable();
+    uint32_t wrap = access_wrap.load();
+    if (access_table_wrap.load() != wrap) {
+        // 访问纪元已回绕，表中255轮之前的纪元可能与当前纪元相同而被误判为热对象，须先清空
+        size_t slot_count = typeTableSlot(reinterpret_cast<char*>(startAddress) + total_size) + 1;
+        for (size_t i = 0; i < slot_count; i++)
+            table[i].store(0);
+        access_table_wrap.store(wrap);
+    }
+    std::atomic<uint8_t>& slot = table[typeTableSlot(const_cast<void*>(object_addr))];
+    uint8_t epoch = access_epoch.load();
+    if (slot.load(std::memory_order_relaxed) == epoch)     // 先读后写，避免反复访问的热对象所在缓存行被频繁写入
+        return;
+    slot.store(epoch);
+    // 读取纪元后访问纪元可能已回绕，而其他线程的清空可能先于本次写入完成，此时写入的是上一次回绕的纪元，须撤销；
+    // 若重新读取时尚未回绕，则本次写入在全序上先于回绕，必然先于回绕后的清空，会被清空覆盖
+    // 撤销使用CAS，只在槽位仍为本次写入的纪元时清零，不覆盖其他线程在回绕后写入的新纪元
+    if (access_wrap.load() != wrap)
+        slot.compare_exchange_strong(epoch, 0);
+}
+
+bool GCRegion::isHot(void* object_addr) const {
+    std::atomic<uint8_t>* table = access_table.load(std::memory_order_acquire);
+    if (table == nullptr || access_table_wrap.load(std::memory_order_relaxed) != access_wrap.load(std::memory_order_relaxed))
+        return false;
+    uint8_t stamp = table[typeTableSlot(object_addr)].load(std::memory_order_relaxed);
+    if (stamp == 0) return false;
+    uint8_t epoch = access_epoch.load(std::memory_order_relaxed);
+    uint8_t previous = epoch == 1 ? 255 : epoch - 1;
+    return stamp == epoch || stamp == previous;
+}
+
+void GCRegion::advanceAccessEpoch() {
+    // 跳过0，0表示从未被访问过
+    uint8_t epoch = access_epoch.load();
+    if (epoch == 255) {
+        access_wrap.fetch_add(1);
+        access_epoch.store(1);
     } else {
-        std::clog << "Warning: Destructor not found of " << object_addr << " in region " << this << std::endl;
+        access_epoch.store(epoch + 1);
     }
 }
 
-void GCRegion::callMoveConstructor(void* source_addr, void* target_addr) {
-    std::shared_lock<std::shared_mutex> lock(move_constructor_map_mtx);
-    auto it = move_constructor_map->find(source_addr);
-    if (it != move_constructor_map->end()) {
-        auto& move_constructor = it->second;
-        move_constructor(source_addr, target_addr);
+GCTypeRegistry::TypeId GCRegion::takeTypeId(void* object_addr) {
+    std::atomic<GCTypeRegistry::TypeId>* table = type_table.load(std::memory_order_acquire);
+    if (table == nullptr) return GCTypeRegistry::NO_TYPE;
+    return table[typeTableSlot(object_addr)].exchange(GCTypeRegistry::NO_TYPE, std::memory_order_relaxed);
+}
+
+void GCRegion::callDestructor(void* object_addr) {
+    // 取出类型编号后清零，保证析构函数只被调用一次；平凡析构的对象未登记类型编号
+    const GCTypeDescriptor* descriptor = GCTypeRegistry::getDescriptor(takeTypeId(object_addr));
+    if (descriptor != nullptr && descriptor->destructor != nullptr)
+        descriptor->destructor(object_addr);
+}
+
+void GCRegion::finalizeObject(void* object_addr, GCFinalizer::Batch& batch) {
+    if (GCWorker::getWorker()->getFinalizer() == nullptr) {
+        callDestructor(object_addr);
+        return;
     }
+    // 将析构函数交由终结器线程执行
+    const GCTypeDescriptor* descriptor = GCTypeRegistry::getDescriptor(takeTypeId(object_addr));
+    if (descriptor != nullptr && descriptor->destructor != nullptr)
+        batch.emplace_back(object_addr, descriptor);
+}
+
+void GCRegion::submitFinalization(GCFinalizer::Batch& batch) {
+    if (batch.empty()) return;
+    finalization_pending->fetch_add(1);
+    GCWorker::getWorker()->getFinalizer()->submit(std::move(batch), finalization_pending);
 }
 
 bool GCRegion::inside_region(void* addr, size_t size) const {
@@ -415,12 +766,12 @@ bool GCRegion::inside_region(void* addr, size_t size) const {
 }
 
 void GCRegion::inc_use_count() {
-    ++use_count;
+    use_count.inc();
 }
 
 void GCRegion::dec_use_count() {
-    --use_count;
-    if (GCParameter::zeroCountCondition && use_count == 0)
+    use_count.dec();
+    if (GCParameter::zeroCountCondition && zero_use_count())
         zero_count_condition.notify_all();
 }
 
@@ -12,6 +12,8 @@
 #include <functional>
 #include <cstring>
 #include <stdexcept>
+#include <bit>
+#include <cstdint>
 #include "GCWorker.h"
 #include "GCBitMap.h"
 #include "GCRegionalHashMap.h"
@@ -21,6 +23,10 @@
 #include "PhaseEnum.h"
 #include "IAllocatable.h"
 #include "IMemoryAllocator.h"
+#include "StripedCounter.h"
+#include "GCCpuBudget.h"
+#include "GCFinalizer.h"
+#include "GCTypeDescriptor.h"
 
 class GCWorker;
 
@@ -52,8 +58,18 @@ public:
     static constexpr bool use_regional_hashmap = GCParameter::useRegionalHashmap;
     static constexpr bool enable_destructor = GCParameter::enableDestructorSupport;
     static constexpr bool enable_move_constructor = GCParameter::enableMoveConstructor;
+    static constexpr bool record_object_start = GCParameter::useConservativeStackScan;
+    static constexpr size_t OBJECT_START_GRANULE = 8;
 
 private:
+    // 一段被整体转移的连续存活对象，段内对象转移前后的相对位置不变
+    struct ForwardingRange {
+        char* begin;
+        char* end;
+        char* new_begin;
+        std::shared_ptr<GCRegion> new_region;
+    };
+
     void* startAddress;
     size_t total_size;
     std::atomic<size_t> allocated_offset;
@@ -63,17 +79,48 @@ private:
     std::unique_ptr<GCBitMap> bitmap;                       // bitmap
     std::unique_ptr<GCRegionalHashMap> regionalHashMap;     // regional hash map
     std::unordered_map<void*, std::pair<void*, std::shared_ptr<GCRegion>>> forwarding_table;
+    std::vector<ForwardingRange> forwarding_ranges;         // 按begin升序，由转移本region的GC线程追加
     std::shared_mutex forwarding_table_mutex;
-    std::unique_ptr<std::unordered_map<void*, std::function<void(void*)>>> destructor_map;
-    std::shared_mutex destructor_map_mtx;
-    std::unique_ptr<std::unordered_map<void*, std::function<void(void*, void*)>>> move_constructor_map;
-    std::shared_mutex move_constructor_map_mtx;
+    std::atomic<std::atomic<GCTypeRegistry::TypeId>*> type_table;   // 对象的类型编号表，按对象起始位置所在的槽位索引，首次登记时创建
+    std::atomic<std::atomic<uint8_t>*> access_table;        // 冷热分离用的访问记录表，与类型编号表同样按槽位索引，记录对象最近一次被抽样访问时的访问纪元
+    std::atomic<uint32_t> access_table_wrap;                // 访问记录表中的纪元所属的回绕次数，与access_wrap不等时表中的纪元均已失效
     std::recursive_mutex relocation_mutex;
     IMemoryAllocator* memoryAllocator;
     std::atomic<bool> evacuated;
-    std::atomic<int> use_count;             // PtrGuardãPtrGuardڼֹضλ
+    StripedCounter<GCParameter::useCountStripes> use_count;     // 记录PtrGuard的引用，PtrGuard存在期间禁止重定位；按线程分条计数以避免缓存行争用
     std::mutex zero_count_mutex;
     std::condition_variable zero_count_condition;
+    std::unique_ptr<std::atomic<uint64_t>[]> object_start_map;  // 对象起始位置图，每bit对应8字节，供保守式栈扫描由任意地址找到所在对象
+    std::atomic<bool> stack_pinned;                             // 本轮GC被线程栈引用，不可重定位
+    bool leaf;                                                  // 叶子region，其中的对象均不含GCPtr
+    std::shared_ptr<std::atomic<size_t>> finalization_pending;  // 已提交给终结器线程但尚未执行完的批次数，非零时释放的内存须经终结器线程归还；与终结器线程共享，region析构后仍可安全递减
+    std::atomic<bool> evacuation_failed;                        // 转移预留空间耗尽或无法申请到内存，本region中尚未转移的对象留在原地
+    std::atomic<bool> guards_drained;                           // 负责转移本region的线程已等到PtrGuard全部释放，此后其它线程才可代为转移其中的对象
+    std::atomic<bool> kept_in_place;                            // 转移失败被原地保留，下一轮不再选入转移集合
+
+    static std::atomic<uint8_t> access_epoch;                   // 访问纪元，每轮选择转移集合时加一，取值1~255循环
+    static std::atomic<uint32_t> access_wrap;                   // 访问纪元的回绕次数
+    static thread_local int access_sample_countdown;
+
+    size_t alignObjectSize(size_t size) const;
+
+    void markAllocated(void* object_addr, size_t size);
+
+    // 须持有forwarding_table_mutex；先查逐个对象的转发表，再查整段转移的区间
+    bool lookupForwarding(void* object_addr, std::pair<void*, std::shared_ptr<GCRegion>>& result) const;
+
+    // 转移一段连续的存活对象，objects为各对象在region内的(偏移, 大小)，须首尾相接
+    void relocateRun(const std::vector<std::pair<size_t, size_t>>& objects);
+
+    size_t typeTableSlot(void* object_addr) const;
+
+    std::atomic<GCTypeRegistry::TypeId>* ensureTypeTable();
+
+    GCTypeRegistry::TypeId takeTypeId(void* object_addr);
+
+    std::atomic<uint8_t>* ensureAccessTable();
+
+    void setObjectStart(void* object_addr, bool is_start);
 
 protected:
     float getFragmentRatio() const;
@@ -82,33 +129,48 @@ protected:
 
     void callDestructor(void*);
 
-    void callMoveConstructor(void*, void*);
+    void finalizeObject(void*, GCFinalizer::Batch&);
+
+    void submitFinalization(GCFinalizer::Batch&);
 
 public:
     struct GCRegionHash {
         size_t operator()(const GCRegion& p) const;
     };
 
-    GCRegion(RegionEnum regionType, void* startAddress, size_t total_size, IMemoryAllocator* memoryAllocator);
+    GCRegion(RegionEnum regionType, void* startAddress, size_t total_size, IMemoryAllocator* memoryAllocator,
+             bool leaf = false);
 
     GCRegion(const GCRegion&) = delete;
 
     GCRegion(GCRegion&&) noexcept;
 
+    ~GCRegion();
+
     size_t getTotalSize() const { return total_size; }
 
     void* getStartAddr() const { return startAddress; }
 
     RegionEnum getRegionType() const { return regionType; }
 
+    // 叶子region中的对象不含GCPtr，标记时只需设置标记位，无需读取对象内容
+    bool isLeaf() const { return leaf; }
+
     void* allocate(size_t size) override;
 
+    // 预留size字节的连续空间但不标记，用于整段转移，由转移方对其中每个对象调用markAllocated()
+    void* allocateRun(size_t size);
+
     void free(void* addr, size_t size) override;
 
-    void mark(void* object_addr, size_t object_size);
+    // 标记对象，返回本次新标记的字节数（对象已被标记过则为0）；存活字节数由调用方通过addLiveSize()累加
+    size_t mark(void* object_addr, size_t object_size);
 
     bool marked(void* object_addr);
 
+    // 预取对象头及其标记状态所在的缓存行
+    void prefetchForMark(void* object_addr) const;
+
     void clearUnmarked();
 
     bool canFree() const;
@@ -125,9 +187,22 @@ public:
 
     void resetLiveSize() { live_size = 0; }
 
+    void addLiveSize(size_t size) { live_size += size; }
+
+    size_t getLiveSize() const { return live_size.load(); }
+
     void triggerRelocation();
 
-    void relocateObject(void*, size_t);
+    // hot为true时直接视为热对象，不再查询访问记录
+    void relocateObject(void*, size_t, bool hot = false);
+
+    bool evacuationFailed() const { return evacuation_failed.load(); }
+
+    bool guardsDrained() const { return guards_drained.load(); }
+
+    // 转移失败后原地保留本region：撤销evacuated标识，本轮已转移出去的对象仍经转发表自愈
+    // evacuation_failed保留到下一轮选择转移集合时（此时标记阶段已完成重映射）才清除，使仍在读屏障中的应用线程不会再转移其中的对象
+    void keepInPlace();
 
     std::pair<void*, std::shared_ptr<GCRegion>> queryForwardingTable(void*);
 
@@ -135,15 +210,43 @@ public:
 
     void reclaim();
 
-    void registerDestructor(void*, const std::function<void(void*)>&);
+    // 记录对象的类型编号，用于回收时查找析构函数、转移时查找移动构造函数；不加锁
+    void setTypeId(void* object_addr, GCTypeRegistry::TypeId type_id);
+
+    GCTypeRegistry::TypeId getTypeId(void* object_addr) const;
 
-    void registerMoveConstructor(void*, const std::function<void(void*, void*)>&);
+    // 抽样记录应用线程对对象的访问，每个线程每accessSampleInterval次调用记录一次；未启用冷热分离时为空操作
+    void sampleAccess(const void* object_addr) {
+        if constexpr (GCParameter::enableHotColdRelocation) {
+            if (--access_sample_countdown <= 0) {
+                access_sample_countdown = GCParameter::accessSampleInterval;
+                recordAccess(object_addr);
+            }
+        }
+    }
+
+    // 将对象记为在当前访问纪元内被访问过；须在持有PtrGuard时调用，已转移或已释放的region不再记录
+    void recordAccess(const void* object_addr);
+
+    // 对象在当前或上一个访问纪元内被访问过，即自上一轮选择转移集合以来为热对象；纪元回绕后本region尚未记录过访问时一律视为冷对象
+    bool isHot(void* object_addr) const;
+
+    static void advanceAccessEpoch();
 
     void inc_use_count();
 
     void dec_use_count();
 
-    bool zero_use_count() const { return use_count == 0; }
+    bool zero_use_count() const { return use_count.isZero(); }
+
+    bool findObjectStart(void* addr, void*& object_addr, size_t& object_size) const;
+
+    void setStackPinned() { stack_pinned.store(true); }
+
+    bool testAndClearStackPinned() { return stack_pinned.exchange(false); }
+
+    // 在STW中选择转移集合时调用，返回上一轮是否被原地保留，并清除保留的转移失败标识
+    bool testAndClearKeptInPlace();
 };
 
 
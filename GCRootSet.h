@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <mutex>
 #include <shared_mutex>
+#include <algorithm>
 #include "GCPtrBase.h"
 #include "Iterator.h"
 
@@ -14,6 +15,12 @@ private:
     std::vector<GCPtrBase**> address_arr;
     static constexpr int SINGLE_BLOCK_SIZE = 1024;
     size_t p_tail;
+    size_t scan_cursor;                     // 分块扫描的进度，小于它的槽位已扫描过；为0表示当前不在扫描
+    std::vector<GCPtrBase*> moved_roots;    // 分块扫描期间从未扫描区域被移入已扫描区域的根
+
+    GCPtrBase*& slot(size_t p) {
+        return address_arr[p / SINGLE_BLOCK_SIZE][p % SINGLE_BLOCK_SIZE];
+    }
 
     void addBlock() {
         void* mem = ::malloc(SINGLE_BLOCK_SIZE * sizeof(GCPtrBase*));
@@ -22,7 +29,7 @@ private:
     }
 
 public:
-    GCRootSet() : p_tail(1) {
+    GCRootSet() : p_tail(1), scan_cursor(0) {
     }
 
     ~GCRootSet() {
@@ -60,6 +67,35 @@ public:
         address_arr[c_idx][c_offset] = c_tail;
         c_tail->setRootsetOffset(p);
         p_tail--;
+        // 被移除的根可能正在补扫列表中，须一并移除，否则下一块会访问已析构的GCPtr
+        if (scan_cursor != 0 && p < scan_cursor && !moved_roots.empty())
+            std::erase(moved_roots, from);
+        // 末尾的根被移到了已扫描的位置，记下来由下一块补扫，否则它会被本轮扫描漏掉
+        if (scan_cursor != 0 && p < scan_cursor && static_cast<size_t>(p_tail_) >= scan_cursor)
+            moved_roots.push_back(c_tail);
+    }
+
+    // 以下分块扫描的接口均须在持有根集合锁时调用，块与块之间可以释放锁
+    void beginChunkedScan() {
+        scan_cursor = 1;
+        moved_roots.clear();
+    }
+
+    // 对下一块中至多chunk_size个根调用func，全部扫描完毕时返回true
+    template<typename Func>
+    bool scanChunk(size_t chunk_size, Func&& func) {
+        for (GCPtrBase* moved : moved_roots)
+            func(moved);
+        moved_roots.clear();
+        size_t end = std::min(scan_cursor + chunk_size, p_tail);
+        for (size_t p = scan_cursor; p < end; p++)
+            func(slot(p));
+        scan_cursor = end;
+        if (scan_cursor >= p_tail) {
+            scan_cursor = 0;
+            return true;
+        }
+        return false;
     }
 
     size_t getSize() const {
@@ -0,0 +1,266 @@
+#include "GCStackScanner.h"
+#include "GCMemoryAllocator.h"
+#include "GCRegion.h"
+#include "GCUtil.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <csetjmp>
+#include <cerrno>
+#include <thread>
+#include <stdexcept>
+#if !_WIN32
+#include <sched.h>
+#endif
+
+#if !_WIN32
+#ifdef SIGPWR
+#define GC_SUSPEND_SIGNAL SIGPWR
+#else
+#define GC_SUSPEND_SIGNAL SIGXCPU
+#endif
+#endif
+
+std::atomic<GCStackScanner::ThreadRecord*> GCStackScanner::suspending_record{nullptr};
+alignas(16) unsigned char GCStackScanner::suspended_context[GCStackScanner::CONTEXT_BUFFER_SIZE];
+std::atomic<size_t> GCStackScanner::suspended_context_size{0};
+thread_local GCStackScanner::ThreadRegistration GCStackScanner::current_registration;
+
+GCStackScanner::ThreadRegistration::~ThreadRegistration() {
+    if (scanner != nullptr && record != nullptr)
+        scanner->unregisterThread(record);
+    record = nullptr;
+}
+
+GCStackScanner::GCStackScanner(GCMemoryAllocator* memoryAllocator) :
+        memoryAllocator(memoryAllocator), stack_buffer(nullptr), stack_buffer_capacity(0) {
+#if !_WIN32
+    struct sigaction action{};
+    action.sa_sigaction = &GCStackScanner::suspendHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigfillset(&action.sa_mask);
+    if (sigaction(GC_SUSPEND_SIGNAL, &action, nullptr) != 0)
+        throw std::runtime_error("GCStackScanner::GCStackScanner(): Failed to install thread suspend signal handler");
+#endif
+}
+
+GCStackScanner::~GCStackScanner() {
+    std::unique_lock<std::mutex> lock(thread_records_mutex);
+    for (ThreadRecord* record : thread_records) {
+#if _WIN32
+        CloseHandle(record->thread_handle);
+#endif
+        delete record;
+    }
+    thread_records.clear();
+    if (current_registration.scanner == this)
+        current_registration.record = nullptr;
+}
+
+void GCStackScanner::registerCurrentThreadSlow() {
+    auto* record = new ThreadRecord();
+    GCUtil::get_stack_bounds(record->stack_low, record->stack_high);
+    record->suspended_sp.store(nullptr);
+    record->suspend_state.store(THREAD_RUNNING);
+#if _WIN32
+    DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &record->thread_handle,
+                    0, FALSE, DUPLICATE_SAME_ACCESS);
+    record->thread_id = GetCurrentThreadId();
+#else
+    record->thread = pthread_self();
+    sigset_t signal_set;
+    sigemptyset(&signal_set);
+    sigaddset(&signal_set, GC_SUSPEND_SIGNAL);
+    pthread_sigmask(SIG_UNBLOCK, &signal_set, nullptr);
+#endif
+    {
+        std::unique_lock<std::mutex> lock(thread_records_mutex);
+        thread_records.push_back(record);
+    }
+    current_registration.scanner = this;
+    current_registration.record = record;
+}
+
+void GCStackScanner::unregisterThread(ThreadRecord* record) {
+    std::unique_lock<std::mutex> lock(thread_records_mutex);
+    auto it = std::find(thread_records.begin(), thread_records.end(), record);
+    if (it == thread_records.end()) return;
+    thread_records.erase(it);
+#if _WIN32
+    CloseHandle(record->thread_handle);
+#endif
+    delete record;
+}
+
+#if !_WIN32
+void GCStackScanner::suspendHandler(int, siginfo_t*, void* context) {
+    // 仅调用异步信号安全的操作
+    int saved_errno = errno;
+    ThreadRecord* record = suspending_record.load();
+    if (record == nullptr) {
+        errno = saved_errno;
+        return;
+    }
+    // 被中断处的寄存器保存在信号栈帧中，位于当前栈帧之上，从当前栈帧开始扫描即可覆盖
+    volatile char marker = 0;
+    char* sp = const_cast<char*>(&marker);
+    if (sp < record->stack_low || sp >= record->stack_high) {
+        // 运行在备用信号栈上，从被中断处的栈顶开始扫描
+#if defined(__linux__) && defined(__x86_64__)
+        sp = reinterpret_cast<char*>(static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RSP]) - 128;   // 含red zone
+#elif defined(__linux__) && defined(__aarch64__)
+        sp = reinterpret_cast<char*>(static_cast<ucontext_t*>(context)->uc_mcontext.sp);
+#else
+        sp = nullptr;
+#endif
+    }
+    size_t context_size = std::min(sizeof(ucontext_t), CONTEXT_BUFFER_SIZE);
+    ::memcpy(suspended_context, context, context_size);
+    suspended_context_size.store(context_size);
+    record->suspended_sp.store(sp);
+    record->suspend_state.store(THREAD_SUSPENDED);
+    while (record->suspend_state.load() != THREAD_RESUME_REQUESTED)
+        sched_yield();
+    record->suspend_state.store(THREAD_RUNNING);
+    errno = saved_errno;
+}
+#endif
+
+size_t GCStackScanner::copyToBuffer(ThreadRecord* record, char* sp) {
+    if (sp == nullptr) {
+        std::clog << "Warning: Cannot locate the stack pointer of a suspended thread, its stack is not scanned" << std::endl;
+        return 0;
+    }
+    sp = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(sp) & ~(sizeof(uintptr_t) - 1));
+    if (sp < record->stack_low) sp = record->stack_low;
+    size_t stack_words = sp < record->stack_high ? (record->stack_high - sp) / sizeof(uintptr_t) : 0;
+    size_t context_words = suspended_context_size.load() / sizeof(uintptr_t);
+    if (stack_words + context_words > stack_buffer_capacity) {
+        // 缓冲区在暂停前已按最大栈大小分配，不应到达此处
+        stack_words = stack_buffer_capacity - context_words;
+    }
+    ::memcpy(stack_buffer.get(), sp, stack_words * sizeof(uintptr_t));
+    ::memcpy(stack_buffer.get() + stack_words, suspended_context, context_words * sizeof(uintptr_t));
+    return stack_words + context_words;
+}
+
+#if _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+size_t GCStackScanner::copyCurrentThreadStack(ThreadRecord* record) {
+    // 当前线程即为被扫描线程（如未启用GC线程时由应用线程执行GC），用setjmp将寄存器写入栈中
+    jmp_buf registers;
+    setjmp(registers);
+    size_t context_size = std::min(sizeof(jmp_buf), CONTEXT_BUFFER_SIZE);
+    ::memcpy(suspended_context, &registers, context_size);
+    suspended_context_size.store(context_size);
+    return copyToBuffer(record, reinterpret_cast<char*>(&registers));
+}
+
+size_t GCStackScanner::copyThreadStack(ThreadRecord* record) {
+#if _WIN32
+    if (record->thread_id == GetCurrentThreadId())
+        return copyCurrentThreadStack(record);
+    if (SuspendThread(record->thread_handle) == (DWORD) -1) {
+        std::clog << "Warning: Failed to suspend thread 0x" << std::hex << record->thread_id << std::dec << std::endl;
+        return 0;
+    }
+    CONTEXT context;
+    context.ContextFlags = CONTEXT_FULL;
+    size_t word_count = 0;
+    if (GetThreadContext(record->thread_handle, &context)) {    // GetThreadContext会等待线程真正暂停
+#if _WIN64
+        char* sp = reinterpret_cast<char*>(context.Rsp);
+#else
+        char* sp = reinterpret_cast<char*>(context.Esp);
+#endif
+        size_t context_size = std::min(sizeof(CONTEXT), CONTEXT_BUFFER_SIZE);
+        ::memcpy(suspended_context, &context, context_size);
+        suspended_context_size.store(context_size);
+        word_count = copyToBuffer(record, sp);
+    } else {
+        std::clog << "Warning: Failed to get context of thread 0x" << std::hex << record->thread_id << std::dec << std::endl;
+    }
+    ResumeThread(record->thread_handle);
+    return word_count;
+#else
+    if (pthread_equal(record->thread, pthread_self()))
+        return copyCurrentThreadStack(record);
+    record->suspend_state.store(THREAD_RUNNING);
+    suspending_record.store(record);
+    if (pthread_kill(record->thread, GC_SUSPEND_SIGNAL) != 0) {
+        suspending_record.store(nullptr);
+        std::clog << "Warning: Failed to suspend a registered thread, its stack is not scanned" << std::endl;
+        return 0;
+    }
+    while (record->suspend_state.load() != THREAD_SUSPENDED)
+        std::this_thread::yield();
+    size_t word_count = copyToBuffer(record, record->suspended_sp.load());
+    suspending_record.store(nullptr);
+    record->suspend_state.store(THREAD_RESUME_REQUESTED);
+    while (record->suspend_state.load() != THREAD_RUNNING)
+        std::this_thread::yield();
+    return word_count;
+#endif
+}
+
+GCRegion* GCStackScanner::lookupRegion(void* addr) const {
+    auto it = std::upper_bound(region_snapshot.begin(), region_snapshot.end(), addr,
+                               [](void* a, const std::pair<void*, GCRegion*>& p) { return a < p.first; });
+    if (it == region_snapshot.begin()) return nullptr;
+    --it;
+    GCRegion* region = it->second;
+    return region->inside_region(addr) ? region : nullptr;
+}
+
+void GCStackScanner::scanThreadStacks(std::vector<ObjectInfo>* stack_roots) {
+    memoryAllocator->getRegionMapSnapshot(region_snapshot);
+    if (region_snapshot.empty()) return;
+    void* heap_low = region_snapshot.front().first;
+    GCRegion* last_region = region_snapshot.back().second;
+    void* heap_high = reinterpret_cast<char*>(last_region->getStartAddr()) + last_region->getTotalSize();
+
+    std::unique_lock<std::mutex> lock(thread_records_mutex);
+    size_t required_capacity = 0;
+    for (ThreadRecord* record : thread_records)
+        required_capacity = std::max(required_capacity, static_cast<size_t>(record->stack_high - record->stack_low) / sizeof(uintptr_t));
+    required_capacity += CONTEXT_BUFFER_SIZE / sizeof(uintptr_t);
+    if (required_capacity > stack_buffer_capacity) {
+        stack_buffer = std::unique_ptr<uintptr_t[]>(new uintptr_t[required_capacity]);
+        stack_buffer_capacity = required_capacity;
+    }
+
+    size_t found_count = 0;
+    for (ThreadRecord* record : thread_records) {
+        size_t word_count = copyThreadStack(record);
+        for (size_t i = 0; i < word_count; i++) {
+            void* candidate = reinterpret_cast<void*>(stack_buffer[i]);
+            if (candidate < heap_low || candidate >= heap_high) continue;
+            GCRegion* region = lookupRegion(candidate);
+            if (region == nullptr) continue;
+            if (stack_roots == nullptr) {
+                region->setStackPinned();
+                found_count++;
+                continue;
+            }
+            void* object_addr;
+            size_t object_size;
+            if (region->findObjectStart(candidate, object_addr, object_size)) {
+                stack_roots->push_back(ObjectInfo{object_addr, object_size, region});
+                found_count++;
+            }
+        }
+    }
+    std::clog << "Stack scan: " << thread_records.size() << " threads, " << found_count
+              << (stack_roots == nullptr ? " references pinned" : " roots found") << std::endl;
+}
+
+void GCStackScanner::scanStacks(std::vector<ObjectInfo>& stack_roots) {
+    scanThreadStacks(&stack_roots);
+}
+
+void GCStackScanner::pinStackRegions() {
+    scanThreadStacks(nullptr);
+}
@@ -0,0 +1,107 @@
+#ifndef CPPGCPTR_GCSTACKSCANNER_H
+#define CPPGCPTR_GCSTACKSCANNER_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "ObjectInfo.h"
+#if _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+class GCRegion;
+
+class GCMemoryAllocator;
+
+/* 保守式线程栈扫描
+ * 启用后栈上的GCPtr不再加入根集合，改为：
+ * 1. 初始标记时逐个暂停曾构造过GCPtr的线程，将其栈（连同寄存器上下文）复制到预分配的缓冲区后立即恢复该线程
+ * 2. 对缓冲区中每个字，通过region表快照和region内的对象起始位置图判断其是否指向某个对象（允许内部指针），命中的对象作为根进行标记
+ * 3. 重标记时再扫描一次，被线程栈引用的region本轮不参与重定位，因为栈上的字无法被更新
+ * 暂停期间GC线程只做内存复制，不加锁也不分配内存，避免与被暂停线程持有的锁（如malloc内部锁）死锁
+ * Linux/macOS通过信号暂停线程，Windows通过SuspendThread/GetThreadContext
+ */
+class GCStackScanner {
+private:
+    struct ThreadRecord {
+#if _WIN32
+        HANDLE thread_handle;
+        DWORD thread_id;
+#else
+        pthread_t thread;
+#endif
+        char* stack_low;
+        char* stack_high;
+        std::atomic<char*> suspended_sp;
+        std::atomic<int> suspend_state;
+    };
+
+    struct ThreadRegistration {
+        GCStackScanner* scanner = nullptr;
+        ThreadRecord* record = nullptr;
+
+        ~ThreadRegistration();
+    };
+
+    static constexpr int THREAD_RUNNING = 0;
+    static constexpr int THREAD_SUSPENDED = 1;
+    static constexpr int THREAD_RESUME_REQUESTED = 2;
+    static constexpr size_t CONTEXT_BUFFER_SIZE = 8192;
+
+    static std::atomic<ThreadRecord*> suspending_record;
+    alignas(16) static unsigned char suspended_context[CONTEXT_BUFFER_SIZE];
+    static std::atomic<size_t> suspended_context_size;
+    static thread_local ThreadRegistration current_registration;
+
+    GCMemoryAllocator* memoryAllocator;
+    std::mutex thread_records_mutex;
+    std::vector<ThreadRecord*> thread_records;
+    std::unique_ptr<uintptr_t[]> stack_buffer;
+    size_t stack_buffer_capacity;
+    std::vector<std::pair<void*, GCRegion*>> region_snapshot;
+
+    size_t copyThreadStack(ThreadRecord* record);
+
+    size_t copyCurrentThreadStack(ThreadRecord* record);
+
+    size_t copyToBuffer(ThreadRecord* record, char* sp);
+
+    GCRegion* lookupRegion(void* addr) const;
+
+    void scanThreadStacks(std::vector<ObjectInfo>* stack_roots);
+
+    void unregisterThread(ThreadRecord* record);
+
+#if !_WIN32
+    static void suspendHandler(int, siginfo_t*, void*);
+#endif
+
+public:
+    explicit GCStackScanner(GCMemoryAllocator* memoryAllocator);
+
+    ~GCStackScanner();
+
+    GCStackScanner(const GCStackScanner&) = delete;
+
+    // 登记当前线程，使其栈在初始标记时被扫描；每个线程只在首次调用时生效
+    void registerCurrentThread() {
+        if (current_registration.record == nullptr)
+            registerCurrentThreadSlow();
+    }
+
+    void registerCurrentThreadSlow();
+
+    // 初始标记：扫描所有已登记线程的栈，将被引用的对象加入stack_roots
+    void scanStacks(std::vector<ObjectInfo>& stack_roots);
+
+    // 重标记：扫描所有已登记线程的栈，钉住被引用的region，使其本轮不被重定位
+    void pinStackRegions();
+};
+
+
+#endif //CPPGCPTR_GCSTACKSCANNER_H
@@ -0,0 +1,263 @@
+#include "GCThreadRootSet.h"
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <iostream>
+
+thread_local GCRootSegment* GCThreadRootSet::local_segment = nullptr;
+
+namespace {
+    // 线程退出时交还其根集合分段，分段中残留的根（如该线程创建的全局GCPtr）仍会被扫描，分段之后可被新线程复用
+    struct GCRootSegmentReleaser {
+        GCRootSegment** segment_ref = nullptr;
+        std::atomic<bool>* owned = nullptr;
+
+        ~GCRootSegmentReleaser() {
+            if (segment_ref != nullptr) *segment_ref = nullptr;
+            if (owned != nullptr) owned->store(false);
+        }
+    };
+
+    thread_local GCRootSegmentReleaser segment_releaser;
+}
+
+GCRootSegment::GCRootSegment(int segment_id) : segment_id(segment_id), p_tail(1), tombstone_count(0), owned(true),
+                                               owner_busy(false), remote_busy(0), gc_scanning(false),
+                                               frame_top(nullptr), frame_slot_count(0) {
+    for (auto& block : blocks)
+        block.store(nullptr, std::memory_order_relaxed);
+}
+
+GCRootSegment::~GCRootSegment() {
+    for (auto& block : blocks) {
+        std::atomic<GCPtrBase*>* p = block.load();
+        if (p == nullptr) break;
+        ::free(reinterpret_cast<void*>(p));
+    }
+}
+
+void GCRootSegment::ensureBlock(size_t p) {
+    size_t block_idx = p / SINGLE_BLOCK_SIZE;
+    if (block_idx >= MAX_BLOCK_COUNT)
+        throw std::logic_error("GCRootSegment::ensureBlock(): Too many gc roots in a single thread");
+    if (blocks[block_idx].load(std::memory_order_relaxed) != nullptr) return;
+    void* mem = ::malloc(SINGLE_BLOCK_SIZE * sizeof(std::atomic<GCPtrBase*>));
+    if (mem == nullptr)
+        throw std::bad_alloc();
+    auto* new_block = reinterpret_cast<std::atomic<GCPtrBase*>*>(mem);
+    for (int i = 0; i < SINGLE_BLOCK_SIZE; i++)
+        new (&new_block[i]) std::atomic<GCPtrBase*>(nullptr);
+    blocks[block_idx].store(new_block, std::memory_order_release);
+}
+
+void GCRootSegment::enterOwner() {
+    // 与enterGC构成Dekker式握手：双方先声明自己，再检查对方，必须使用seq_cst
+    owner_busy.store(true);
+    while (gc_scanning.load()) {
+        owner_busy.store(false);
+        while (gc_scanning.load())
+            std::this_thread::yield();
+        owner_busy.store(true);
+    }
+}
+
+void GCRootSegment::enterRemote() {
+    remote_busy.fetch_add(1);
+    while (gc_scanning.load()) {
+        remote_busy.fetch_sub(1);
+        while (gc_scanning.load())
+            std::this_thread::yield();
+        remote_busy.fetch_add(1);
+    }
+}
+
+void GCRootSegment::enterGC() {
+    gc_scanning.store(true);
+    while (owner_busy.load() || remote_busy.load() > 0)
+        std::this_thread::yield();
+}
+
+void GCRootSegment::add(GCPtrBase* from) {
+    enterOwner();
+    size_t p = p_tail.load(std::memory_order_relaxed);
+    if (p % SINGLE_BLOCK_SIZE == 0 || p == 1) {
+        try {
+            ensureBlock(p);
+        } catch (...) {
+            leaveOwner();
+            throw;
+        }
+    }
+    slot(p).store(from, std::memory_order_relaxed);
+    from->setRootsetOffset(GCThreadRootSet::encodeOffset(segment_id, p));
+    p_tail.store(p + 1, std::memory_order_release);
+    leaveOwner();
+}
+
+void GCRootSegment::removeOwned(GCPtrBase* from, size_t p) {
+    size_t tail = p_tail.load(std::memory_order_relaxed);
+    if (p >= tail || p == 0)
+        throw std::invalid_argument("GCRootSegment::remove(): p is greater than p_tail or is equal to 0");
+    if (slot(p).load(std::memory_order_relaxed) != from)
+        throw std::logic_error("GCRootSegment::remove(): p in GCPtr is not equal to p in root set");
+    if (p == tail - 1) {
+        // 后进先出的快速路径：弹出末尾，并顺带回收紧邻末尾的墓碑
+        tail--;
+        while (tail > 1 && slot(tail - 1).load() == nullptr) {
+            tail--;
+            tombstone_count.fetch_sub(1);
+        }
+        p_tail.store(tail, std::memory_order_release);
+    } else {
+        slot(p).store(nullptr);
+        tombstone_count.fetch_add(1);
+    }
+}
+
+void GCRootSegment::removeRemote(GCPtrBase* from, size_t p) {
+    if (p >= p_tail.load() || p == 0)
+        throw std::invalid_argument("GCRootSegment::remove(): p is greater than p_tail or is equal to 0");
+    if (slot(p).load() != from)
+        throw std::logic_error("GCRootSegment::remove(): p in GCPtr is not equal to p in root set");
+    // 先计数再置空，保证所属线程弹出该墓碑时计数已经加上
+    tombstone_count.fetch_add(1);
+    slot(p).store(nullptr);
+}
+
+void GCRootSegment::compact() {
+    // 仅在GC握手期间调用，此时所属线程和其它线程都不会修改该分段
+    size_t tail = p_tail.load();
+    size_t new_tail = 1;
+    for (size_t p = 1; p < tail; p++) {
+        GCPtrBase* gcptr = slot(p).load(std::memory_order_relaxed);
+        if (gcptr == nullptr) continue;
+        if (new_tail != p) {
+            slot(new_tail).store(gcptr, std::memory_order_relaxed);
+            gcptr->setRootsetOffset(GCThreadRootSet::encodeOffset(segment_id, new_tail));
+        }
+        new_tail++;
+    }
+    for (size_t p = new_tail; p < tail; p++)
+        slot(p).store(nullptr, std::memory_order_relaxed);
+    p_tail.store(new_tail);
+    tombstone_count.store(0);
+}
+
+void GCRootSegment::pushFrame(GCRootFrame* frame) {
+    enterOwner();
+    frame->prev = frame_top;
+    frame->segment = this;
+    frame_top = frame;
+    frame_slot_count.fetch_add(frame->count);
+    leaveOwner();
+}
+
+void GCRootSegment::popFrame(GCRootFrame* frame) {
+    enterOwner();
+    if (frame_top == frame) {
+        frame_top = frame->prev;
+    } else {
+        // 根帧应随作用域后进先出，乱序释放时仍从链中摘除以免GC访问已失效的栈内存
+        std::cerr << "Warning: Root frame released out of order" << std::endl;
+        for (GCRootFrame* c_frame = frame_top; c_frame != nullptr; c_frame = c_frame->prev) {
+            if (c_frame->prev == frame) {
+                c_frame->prev = frame->prev;
+                break;
+            }
+        }
+    }
+    frame_slot_count.fetch_sub(frame->count);
+    leaveOwner();
+}
+
+GCThreadRootSet::GCThreadRootSet() : segment_count(0) {
+    for (auto& segment : segments)
+        segment.store(nullptr, std::memory_order_relaxed);
+}
+
+GCThreadRootSet::~GCThreadRootSet() {
+    int count = segment_count.load();
+    for (int i = 0; i < count; i++) {
+        delete segments[i].load();
+        segments[i].store(nullptr);
+    }
+}
+
+GCRootSegment* GCThreadRootSet::acquireSegment() {
+    GCRootSegment* ret = nullptr;
+    int count = segment_count.load();
+    for (int i = 0; i < count; i++) {
+        GCRootSegment* segment = segments[i].load();
+        bool expected = false;
+        if (segment != nullptr && segment->owned.compare_exchange_strong(expected, true)) {
+            ret = segment;
+            break;
+        }
+    }
+    if (ret == nullptr) {
+        std::unique_lock<std::mutex> lock(segment_register_mutex);
+        int segment_id = segment_count.load();
+        if (segment_id >= MAX_SEGMENT_COUNT)
+            throw std::logic_error("GCThreadRootSet::acquireSegment(): Too many threads holding gc roots");
+        ret = new GCRootSegment(segment_id);
+        segments[segment_id].store(ret);
+        segment_count.store(segment_id + 1);
+    }
+    segment_releaser.segment_ref = &local_segment;
+    segment_releaser.owned = &ret->owned;
+    return ret;
+}
+
+void GCThreadRootSet::add(GCPtrBase* from) {
+    getLocalSegment()->add(from);
+}
+
+void GCThreadRootSet::remove(GCPtrBase* from) {
+    size_t offset = from->getRootsetOffset();
+    int segment_id = decodeSegmentId(offset);
+    if (segment_id >= segment_count.load())
+        throw std::invalid_argument("GCThreadRootSet::remove(): Invalid segment id in rootset offset");
+    GCRootSegment* segment = segments[segment_id].load();
+    // 握手期间GC可能压缩分段并改写offset，因此需在进入后重新读取
+    if (segment == local_segment) {
+        segment->enterOwner();
+        try {
+            segment->removeOwned(from, decodeSlot(from->getRootsetOffset()));
+        } catch (...) {
+            segment->leaveOwner();
+            throw;
+        }
+        segment->leaveOwner();
+    } else {
+        segment->enterRemote();
+        try {
+            segment->removeRemote(from, decodeSlot(from->getRootsetOffset()));
+        } catch (...) {
+            segment->leaveRemote();
+            throw;
+        }
+        segment->leaveRemote();
+    }
+}
+
+void GCThreadRootSet::addFrame(GCRootFrame* frame) {
+    getLocalSegment()->pushFrame(frame);
+}
+
+void GCThreadRootSet::removeFrame(GCRootFrame* frame) {
+    if (frame->segment != local_segment)
+        std::cerr << "Warning: Root frame released by a thread other than its owner" << std::endl;
+    frame->segment->popFrame(frame);
+}
+
+size_t GCThreadRootSet::getSize() const {
+    size_t ret = 0;
+    int count = segment_count.load();
+    for (int i = 0; i < count; i++) {
+        GCRootSegment* segment = segments[i].load();
+        if (segment != nullptr)
+            ret += segment->getSize();
+    }
+    return ret;
+}
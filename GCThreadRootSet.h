@@ -0,0 +1,184 @@
+#ifndef CPPGCPTR_GCTHREADROOTSET_H
+#define CPPGCPTR_GCTHREADROOTSET_H
+
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "GCPtrBase.h"
+
+/* 按线程划分的根集合
+ * 每个线程拥有一个根集合分段（GCRootSegment），GCPtr加入/移出根集合时只操作本线程的分段，无需加锁：
+ * 1. 加入时追加到分段末尾；移出时若位于末尾则直接弹出（栈上GCPtr天然满足后进先出），否则置空留下墓碑，待末尾弹出时一并回收
+ * 2. 槽位一经分配不会被其它线程移动，因此别的线程析构该GCPtr（如全局变量、堆外容器中的GCPtr）时只需将槽位置空
+ * 3. GC线程逐个分段与其所属线程握手（Dekker式标志位），握手期间该分段的增删会短暂等待，GC在此期间读取根并按需压缩墓碑
+ * GCPtr中记录的rootset_offset高位为分段编号，低位为槽位下标
+ * 此外每个分段维护一条根帧链（影子栈），一个根帧以一条记录登记一整块连续的GCPtr，入栈出栈均为O(1)
+ */
+class GCRootSegment;
+
+// 根帧：描述一块连续存放、间距为stride的count个GCPtr，由gc::RootFrame在栈上持有
+struct GCRootFrame {
+    GCRootFrame* prev;
+    GCPtrBase* base;
+    size_t count;
+    size_t stride;
+    GCRootSegment* segment;
+
+    GCPtrBase* at(size_t i) const {
+        return reinterpret_cast<GCPtrBase*>(reinterpret_cast<char*>(base) + i * stride);
+    }
+};
+
+class GCRootSegment {
+    friend class GCThreadRootSet;
+
+private:
+    static constexpr int SINGLE_BLOCK_SIZE = 1024;
+    static constexpr int MAX_BLOCK_COUNT = 4096;
+
+    const int segment_id;
+    std::atomic<std::atomic<GCPtrBase*>*> blocks[MAX_BLOCK_COUNT];
+    std::atomic<size_t> p_tail;
+    std::atomic<size_t> tombstone_count;
+    std::atomic<bool> owned;
+    std::atomic<bool> owner_busy;
+    std::atomic<int> remote_busy;
+    std::atomic<bool> gc_scanning;
+    GCRootFrame* frame_top;
+    std::atomic<size_t> frame_slot_count;
+
+    std::atomic<GCPtrBase*>& slot(size_t p) const {
+        return blocks[p / SINGLE_BLOCK_SIZE].load(std::memory_order_relaxed)[p % SINGLE_BLOCK_SIZE];
+    }
+
+    void ensureBlock(size_t p);
+
+    void enterOwner();
+
+    void leaveOwner() {
+        owner_busy.store(false, std::memory_order_release);
+    }
+
+    void enterRemote();
+
+    void leaveRemote() {
+        remote_busy.fetch_sub(1, std::memory_order_release);
+    }
+
+    void enterGC();
+
+    void leaveGC() {
+        gc_scanning.store(false);
+    }
+
+    void add(GCPtrBase* from);
+
+    void removeOwned(GCPtrBase* from, size_t p);
+
+    void removeRemote(GCPtrBase* from, size_t p);
+
+    void compact();
+
+    void pushFrame(GCRootFrame* frame);
+
+    void popFrame(GCRootFrame* frame);
+
+public:
+    explicit GCRootSegment(int segment_id);
+
+    ~GCRootSegment();
+
+    GCRootSegment(const GCRootSegment&) = delete;
+
+    size_t getSize() const {
+        return p_tail.load() - 1 - tombstone_count.load() + frame_slot_count.load();
+    }
+};
+
+class GCThreadRootSet {
+private:
+    static constexpr int MAX_SEGMENT_COUNT = 4096;
+    static constexpr int SEGMENT_ID_SHIFT = 40;
+
+    std::atomic<GCRootSegment*> segments[MAX_SEGMENT_COUNT];
+    std::atomic<int> segment_count;
+    std::mutex segment_register_mutex;
+
+    static thread_local GCRootSegment* local_segment;
+
+    GCRootSegment* acquireSegment();
+
+    GCRootSegment* getLocalSegment() {
+        if (local_segment == nullptr)
+            local_segment = acquireSegment();
+        return local_segment;
+    }
+
+public:
+    GCThreadRootSet();
+
+    ~GCThreadRootSet();
+
+    GCThreadRootSet(const GCThreadRootSet&) = delete;
+
+    static size_t encodeOffset(int segment_id, size_t p) {
+        return static_cast<size_t>(segment_id) << SEGMENT_ID_SHIFT | p;
+    }
+
+    static int decodeSegmentId(size_t offset) {
+        return static_cast<int>(offset >> SEGMENT_ID_SHIFT);
+    }
+
+    static size_t decodeSlot(size_t offset) {
+        return offset & ((static_cast<size_t>(1) << SEGMENT_ID_SHIFT) - 1);
+    }
+
+    void add(GCPtrBase* from);
+
+    void remove(GCPtrBase* from);
+
+    void addFrame(GCRootFrame* frame);
+
+    void removeFrame(GCRootFrame* frame);
+
+    int getSegmentCount() const {
+        return segment_count.load();
+    }
+
+    size_t getSize() const;
+
+    // 与第segment_idx个分段所属线程握手，并对其中每个根调用func；握手期间该分段的增删会被阻塞
+    // 每次握手最多处理chunk_size个槽位，块之间释放握手，所属线程被阻塞的时间与分段大小无关
+    // 块之间槽位不会被移动：新加入的根追加在末尾，移出的根都已经过删除屏障，因此分块扫描与一次性扫描得到的根同样完整
+    template<typename Func>
+    void scanSegment(int segment_idx, size_t chunk_size, Func&& func) {
+        GCRootSegment* segment = segments[segment_idx].load();
+        if (segment == nullptr) return;
+        size_t cursor = 1;
+        while (true) {
+            segment->enterGC();
+            if (cursor == 1 && segment->tombstone_count.load() * 2 > segment->p_tail.load())
+                segment->compact();
+            size_t tail = segment->p_tail.load();
+            size_t end = std::min(cursor + chunk_size, tail);
+            for (size_t p = cursor; p < end; p++) {
+                GCPtrBase* gcptr = segment->slot(p).load(std::memory_order_relaxed);
+                if (gcptr != nullptr)
+                    func(gcptr);
+            }
+            cursor = end;
+            if (cursor >= tail) {
+                for (GCRootFrame* frame = segment->frame_top; frame != nullptr; frame = frame->prev) {
+                    for (size_t i = 0; i < frame->count; i++)
+                        func(frame->at(i));
+                }
+                segment->leaveGC();
+                break;
+            }
+            segment->leaveGC();
+        }
+    }
+};
+
+
+#endif //CPPGCPTR_GCTHREADROOTSET_H
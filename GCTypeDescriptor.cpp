@@ -0,0 +1,13 @@
+#include "GCTypeDescriptor.h"
+#include <stdexcept>
+
+std::atomic<const GCTypeDescriptor*> GCTypeRegistry::descriptors[MAX_TYPE_COUNT];
+std::atomic<size_t> GCTypeRegistry::type_count{1};
+
+GCTypeRegistry::TypeId GCTypeRegistry::registerType(const GCTypeDescriptor* descriptor) {
+    size_t type_id = type_count.fetch_add(1);
+    if (type_id >= MAX_TYPE_COUNT)
+        throw std::logic_error("GCTypeRegistry::registerType(): Too many types managed by GCPtr.");
+    descriptors[type_id].store(descriptor, std::memory_order_release);
+    return static_cast<TypeId>(type_id);
+}
@@ -0,0 +1,46 @@
+#ifndef CPPGCPTR_GCTYPEDESCRIPTOR_H
+#define CPPGCPTR_GCTYPEDESCRIPTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 类型描述符，每个被GCPtr管理的类型一个，在该类型首次分配时创建并登记
+struct GCTypeDescriptor {
+    size_t size;
+    void (*destructor)(void*);                  // 平凡析构的类型为nullptr
+    void (*move_constructor)(void*, void*);     // 仅在启用移动构造函数时非空
+    bool trivially_destructible;
+    bool leaf;                                  // 对象内不含GCPtr，标记时无需扫描对象内容
+};
+
+/* 类型描述符表
+ * region不再为每个对象保存一个std::function形式的析构函数（及移动构造函数）并以对象地址为键加锁插入哈希表，
+ * 而是在region的类型编号表中为每个对象记录一个2字节的类型编号，由编号查此表得到类型描述符：
+ * 1. 记录类型编号只是写入对象所在槽位，无需加锁；转移对象时把编号复制到新region即可
+ * 2. 平凡析构的类型（未启用移动构造函数时）完全不需要记录
+ * 编号0保留，表示对象无需登记；描述符一经登记不会被移除
+ */
+class GCTypeRegistry {
+public:
+    using TypeId = uint16_t;
+    static constexpr TypeId NO_TYPE = 0;
+
+private:
+    static constexpr size_t MAX_TYPE_COUNT = 65536;
+
+    static std::atomic<const GCTypeDescriptor*> descriptors[MAX_TYPE_COUNT];
+    static std::atomic<size_t> type_count;
+
+public:
+    // 登记一个类型描述符并返回其编号，类型数超过上限时抛出std::logic_error
+    static TypeId registerType(const GCTypeDescriptor* descriptor);
+
+    static const GCTypeDescriptor* getDescriptor(TypeId type_id) {
+        if (type_id == NO_TYPE) return nullptr;
+        return descriptors[type_id].load(std::memory_order_acquire);
+    }
+};
+
+
+#endif //CPPGCPTR_GCTYPEDESCRIPTOR_H
@@ -1,22 +1,47 @@
 #include "GCUtil.h"
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#if __linux__
+#include <sched.h>
+#endif
+#if _WIN32 || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 std::vector<DWORD> GCUtil::_suspendedThreadIDs;
 bool GCUtil::user_threads_suspended = false;
 
-bool GCUtil::is_stack_pointer(void* ptr) {
-#if _WIN32 && _MSC_VER
-    if constexpr (!GCParameter::enableMemoryAllocator) {
-        ULONG_PTR low, high;
-        GetCurrentThreadStackLimits(&low, &high);   // 获取当前线程的栈区边界
-        return low <= reinterpret_cast<ULONG_PTR>(ptr) && reinterpret_cast<ULONG_PTR>(ptr) < high;  // 判断指针是否在栈区范围内
-    }
+thread_local char* GCUtil::stack_low_cached = nullptr;
+thread_local char* GCUtil::stack_high_cached = nullptr;
+
+void GCUtil::init_stack_bounds() {
+    // 获取当前线程的栈区边界[stack_low, stack_high)
+#if _WIN32
+    ULONG_PTR low, high;
+    GetCurrentThreadStackLimits(&low, &high);
+    stack_low_cached = reinterpret_cast<char*>(low);
+    stack_high_cached = reinterpret_cast<char*>(high);
+#elif __APPLE__
+    pthread_t self = pthread_self();
+    stack_high_cached = reinterpret_cast<char*>(pthread_get_stackaddr_np(self));
+    stack_low_cached = stack_high_cached - pthread_get_stacksize_np(self);
+#else
+    pthread_attr_t attr;
+    void* addr = nullptr;
+    size_t size = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+        throw std::runtime_error("GCUtil::init_stack_bounds(): pthread_getattr_np() failed");
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    stack_low_cached = reinterpret_cast<char*>(addr);
+    stack_high_cached = stack_low_cached + size;
 #endif
-    // 不确定的一律返回true，前提是启用了析构函数
-    if constexpr (GCParameter::enableDestructorSupport) {
-        return true;
-    } else {
-        throw std::invalid_argument("GCUtil::is_stack_pointer() is not supported on current system");
-    }
 }
 
 int GCUtil::getPoolIdx(int poolCount) {
@@ -118,4 +143,94 @@ void GCUtil::sleep(float sec) {
 #else
     usleep(sec * 1000 * 1000);
 #endif
-}
\ No newline at end of file
+}
+
+void GCUtil::releaseFreeMemoryToOS() {
+    // free()归还的内存通常仍留在C运行库的堆中，并不会立即降低进程的常驻内存
+#if _WIN32
+    _heapmin();
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+int GCUtil::getAvailableCPUCount() {
+    // 可用CPU数取以下三者的最小值：硬件线程数、进程的CPU亲和性掩码、Linux下cgroup的CPU配额（容器中常见）
+    int count = static_cast<int>(std::thread::hardware_concurrency());
+    if (count <= 0) count = 1;
+#if _WIN32
+    DWORD_PTR process_mask, system_mask;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) && process_mask != 0) {
+        int affinity_count = 0;
+        for (DWORD_PTR mask = process_mask; mask != 0; mask &= mask - 1)
+            affinity_count++;
+        count = std::min(count, affinity_count);
+    }
+#elif __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        int affinity_count = CPU_COUNT(&cpu_set);
+        if (affinity_count > 0)
+            count = std::min(count, affinity_count);
+    }
+    // cgroup v2: cpu.max内容为"<quota> <period>"，不限制时quota为"max"
+    double quota = -1, period = -1;
+    std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+    std::string quota_str;
+    if (cpu_max >> quota_str >> period) {
+        if (quota_str != "max")
+            quota = std::stod(quota_str);
+    } else {
+        // cgroup v1: cpu.cfs_quota_us为-1时不限制
+        std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (!(quota_file >> quota) || !(period_file >> period))
+            quota = -1;
+    }
+    if (quota > 0 && period > 0) {
+        int quota_count = static_cast<int>(std::ceil(quota / period));
+        count = std::min(count, std::max(quota_count, 1));
+    }
+#endif
+    return count;
+}
+
+void GCUtil::copyMemory(void* dst, const void* src, size_t size) {
+#if defined(__x86_64__) || defined(_M_X64)
+    if (size >= GCParameter::relocationNonTemporalThreshold) {
+        // 大块复制使用非临时存储直接写入内存，避免转移前后的两份数据同时挤占缓存
+        char* d = static_cast<char*>(dst);
+        const char* s = static_cast<const char*>(src);
+        size_t head = (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16;
+        ::memcpy(d, s, head);
+        d += head;
+        s += head;
+        size -= head;
+        size_t body = size / 64 * 64;
+        for (size_t i = 0; i < body; i += 64) {
+            __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 16));
+            __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 32));
+            __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + i), x0);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + i + 16), x1);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + i + 32), x2);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + i + 48), x3);
+        }
+        _mm_sfence();
+        ::memcpy(d + body, s + body, size - body);
+        return;
+    }
+#endif
+    ::memcpy(dst, src, size);
+}
+
+int GCUtil::getWorkerCount(size_t work_items, size_t min_items_per_worker, int max_workers) {
+    if constexpr (!GCParameter::adaptiveGCThreadCount)
+        return max_workers;
+    if (max_workers <= 1) return max_workers;
+    if (min_items_per_worker == 0) min_items_per_worker = 1;
+    size_t workers = (work_items + min_items_per_worker - 1) / min_items_per_worker;
+    return static_cast<int>(std::clamp<size_t>(workers, 1, static_cast<size_t>(max_workers)));
+}
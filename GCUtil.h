@@ -3,6 +3,8 @@
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <algorithm>
 #include <stdexcept>
 #include "IReadWriteLock.h"
 #include "GCParameter.h"
@@ -12,12 +14,23 @@
 #include <TlHelp32.h>
 #else
 #include <unistd.h>
+#include <pthread.h>
 #endif
 
 #if !_WIN32
 typedef unsigned long       DWORD;
 #endif
 
+// 预取addr所在的缓存行，不支持的编译器上为空操作
+#if defined(__GNUC__) || defined(__clang__)
+#define GC_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define GC_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+#define GC_PREFETCH(addr) ((void)(addr))
+#endif
+
 class GCUtil {
 private:
     static std::vector<DWORD> _suspendedThreadIDs;
@@ -28,15 +41,77 @@ private:
 
     static bool user_threads_suspended;
 
+    static thread_local char* stack_low_cached;
+
+    static thread_local char* stack_high_cached;
+
+    static void init_stack_bounds();
+
 public:
     static void stop_the_world(IReadWriteLock*, ThreadPoolExecutor* gcPool = nullptr,
                                bool suspend_user_thread = true);
 
     static void resume_the_world(IReadWriteLock* = nullptr);
 
-    static bool is_stack_pointer(void* ptr);
+    // 判断指针是否位于当前线程的栈区；栈区边界每个线程只查询一次并缓存，此后仅需两次比较
+    static bool is_stack_pointer(void* ptr) {
+        if (stack_high_cached == nullptr) init_stack_bounds();
+        return reinterpret_cast<char*>(ptr) >= stack_low_cached && reinterpret_cast<char*>(ptr) < stack_high_cached;
+    }
+
+    static void get_stack_bounds(char*& stack_low, char*& stack_high) {
+        if (stack_high_cached == nullptr) init_stack_bounds();
+        stack_low = stack_low_cached;
+        stack_high = stack_high_cached;
+    }
 
     static int getPoolIdx(int poolCount);
 
+    // 当前进程实际可用的CPU数，考虑CPU亲和性以及Linux下cgroup的CPU配额
+    static int getAvailableCPUCount();
+
+    // 根据工作量选择参与某阶段的GC线程数：每个线程至少分到min_items_per_worker项工作，不超过max_workers；未启用adaptiveGCThreadCount时恒为max_workers
+    static int getWorkerCount(size_t work_items, size_t min_items_per_worker, int max_workers);
+
+    // 复制内存；x86-64下不小于relocationNonTemporalThreshold的大块使用非临时存储
+    static void copyMemory(void* dst, const void* src, size_t size);
+
+    // 在线程池上以fork-join方式对[0, n)的每个下标调用func(i)，返回时所有下标均已处理完毕
+    // 不预先均分，而是由threadCount个任务通过共享游标动态领取chunk_size个下标一块：各region耗时相差悬殊时，先完成的线程继续领取剩余的块，
+    // 阶段耗时不再取决于最慢的静态分片。chunk_size为0时自动选取，使每个任务平均领取约8块
+    // on_task_exit在每个任务领取完所有块后调用一次（如协助扫描共享队列中的剩余工作）；threadPool为空时在当前线程串行执行
+    template<typename Func, typename ExitFunc>
+    static void parallel_for(ThreadPoolExecutor* threadPool, int threadCount, size_t n, Func&& func, ExitFunc&& on_task_exit,
+                             size_t chunk_size = 0) {
+        if (threadPool == nullptr || threadCount <= 1) {
+            for (size_t i = 0; i < n; i++) func(i);
+            on_task_exit();
+            return;
+        }
+        if (chunk_size == 0)
+            chunk_size = std::max<size_t>(1, n / (static_cast<size_t>(threadCount) * 8));
+        std::atomic<size_t> cursor(0);
+        for (int tid = 0; tid < threadCount; tid++) {
+            threadPool->execute([&cursor, &func, &on_task_exit, n, chunk_size] {
+                while (true) {
+                    size_t startIndex = cursor.fetch_add(chunk_size);
+                    if (startIndex >= n) break;
+                    size_t endIndex = std::min(startIndex + chunk_size, n);
+                    for (size_t i = startIndex; i < endIndex; i++) func(i);
+                }
+                on_task_exit();
+            });
+        }
+        threadPool->waitForTaskComplete(threadCount);
+    }
+
+    template<typename Func>
+    static void parallel_for(ThreadPoolExecutor* threadPool, int threadCount, size_t n, Func&& func) {
+        parallel_for(threadPool, threadCount, n, std::forward<Func>(func), [] {});
+    }
+
     static void sleep(float sec);
+
+    // 请求C运行库将堆中的空闲内存归还给操作系统，不支持的平台上为空操作
+    static void releaseFreeMemoryToOS();
 };
\ No newline at end of file
@@ -1,13 +1,20 @@
 #include "GCWorker.h"
 
 std::unique_ptr<GCWorker> GCWorker::instance;
+thread_local int GCWorker::allocation_depth = 0;
+thread_local unsigned int GCWorker::mark_assist_cycle_seen = 0;
+thread_local size_t GCWorker::mark_assist_debt = 0;
+thread_local size_t GCWorker::marked_bytes = 0;
+thread_local bool GCWorker::mark_assisting = false;
 
 GCWorker::GCWorker() : GCWorker(false, false, true, false, false, false) {
 }
 
 GCWorker::GCWorker(bool concurrent, bool enableMemoryAllocator, bool enableDestructorSupport, bool useInlineMarkState,
                    bool useSecondaryMemoryManager, bool enableRelocation, bool enableParallel) :
-        stop_(false), ready_(false), enableConcurrentMark(concurrent), enableMemoryAllocator(enableMemoryAllocator) {
+        root_mark_cursor(0), mark_assist_enabled(false), mark_assist_cycle(0), compact_requested(false), compacting(false), compacted_cycles(0),
+        compact_left_regions(0),
+        enableConcurrentMark(concurrent), enableMemoryAllocator(enableMemoryAllocator), stop_(false), ready_(false) {
     std::clog << "GCWorker()" << std::endl;
     if (!enableMemoryAllocator) {
         enableParallel = false;             // 必须启用内存分配器以支持并行垃圾回收
@@ -36,11 +43,18 @@ GCWorker::GCWorker(bool concurrent, bool enableMemoryAllocator, bool enableDestr
             root_set[i].reserve(64);
     }
     if constexpr (GCParameter::useArrayAsRootSet) {
-        gcRootSet = std::make_unique<GCRootSet>();
+        if constexpr (GCParameter::useThreadLocalRootSet) {
+            gcThreadRootSet = std::make_unique<GCThreadRootSet>();
+            gcRootSet = nullptr;
+        } else {
+            gcRootSet = std::make_unique<GCRootSet>();
+            gcThreadRootSet = nullptr;
+        }
         root_set_mutex = nullptr;
     } else {
         root_set_mutex = std::make_unique<std::shared_mutex[]>(poolCount);
         gcRootSet = nullptr;
+        gcThreadRootSet = nullptr;
     }
     if constexpr (GCParameter::useGCPtrSet) {
         gcPtrSet = std::make_unique<std::set<GCPtrBase*>>();
@@ -50,7 +64,11 @@ GCWorker::GCWorker(bool concurrent, bool enableMemoryAllocator, bool enableDestr
         gcPtrSetMtx = nullptr;
     }
     if (enableParallel) {
-        this->gcThreadCount = GCParameter::gcThreadCount;
+        if constexpr (GCParameter::adaptiveGCThreadCount)
+            this->gcThreadCount = GCUtil::getAvailableCPUCount();   // 线程池按可用CPU数创建，各阶段再按工作量决定实际参与的线程数，其余线程阻塞在任务队列上
+        else
+            this->gcThreadCount = GCParameter::gcThreadCount;
+        this->gcThreadLimit = gcThreadCount;
         this->threadPool = std::make_unique<ThreadPoolExecutor>(gcThreadCount, gcThreadCount, 0,
                                                                 std::make_unique<ArrayBlockingQueue<std::function<void()>>>(gcThreadCount),
                                                                 std::make_unique<ThreadPoolExecutor::AbortPolicy>(), true);
@@ -58,6 +76,7 @@ GCWorker::GCWorker(bool concurrent, bool enableMemoryAllocator, bool enableDestr
             this->root_object_snapshots.resize(gcThreadCount);
     } else {
         this->gcThreadCount = 0;
+        this->gcThreadLimit = 0;
         this->threadPool = nullptr;
     }
     if (enableMemoryAllocator) {
@@ -65,6 +84,12 @@ GCWorker::GCWorker(bool concurrent, bool enableMemoryAllocator, bool enableDestr
             this->memoryAllocator = std::make_unique<GCMemoryAllocator>(useSecondaryMemoryManager, true, gcThreadCount, threadPool.get());
         else
             this->memoryAllocator = std::make_unique<GCMemoryAllocator>(useSecondaryMemoryManager);
+        if constexpr (GCParameter::useConservativeStackScan)
+            this->stackScanner = std::make_unique<GCStackScanner>(memoryAllocator.get());
+        if constexpr (GCParameter::enableFinalizerThread) {
+            if (enableDestructorSupport)
+                this->finalizer = std::make_unique<GCFinalizer>();
+        }
     }
     if (concurrent) {
         this->gc_thread = std::make_unique<std::thread>(&GCWorker::GCThreadLoop, this);
@@ -126,37 +151,120 @@ void GCWorker::mark(void* object_addr) {
 }
 
 void GCWorker::mark_v2(GCPtrBase* gcptr) {
-    if (gcptr == nullptr) return;
+    ObjectInfo objectInfo;
+    if (this->visit_gcptr(gcptr, objectInfo))
+        this->mark_v2(objectInfo);
+}
+
+bool GCWorker::visit_gcptr(GCPtrBase* gcptr, ObjectInfo& objectInfo) {
+    if (gcptr == nullptr) return false;
     if constexpr (GCParameter::useGCPtrSet) {
         if (!inside_gcptr_set(gcptr)) {
             std::clog << "Warning: Skipping marking a gcptr which not in gcptr set " << (void*) gcptr << std::endl;
-            return;
+            return false;
         }
     }
     if (gcptr->getInlineMarkState() == MarkState::DE_ALLOCATED) {
         std::clog << "Warning: Skipping marking a deallocated gcptr " << (void*) gcptr << std::endl;
-        return;
+        return false;
     }
 
-    ObjectInfo objectInfo = gcptr->getObjectInfo();
-    if (objectInfo.object_addr == nullptr || objectInfo.region == nullptr) return;
+    objectInfo = gcptr->getObjectInfo();
+    if (objectInfo.object_addr == nullptr || objectInfo.region == nullptr) return false;
     MarkState c_markstate = GCPhase::getCurrentMarkState();
     if (useInlineMarkstate) {
         if (gcptr->getInlineMarkState() == c_markstate) {     // 标记过了
-            return;
+            return false;
         }
         // 客观地说，指针自愈确实应该在标记对象前面
         gcptr->setInlineMarkState(c_markstate);
     }
     // 因为有SATB的存在，并且GC期间新对象一律标为存活，因此不用担心取出来的object_addr和object_region陈旧问题
     // 但是好像object_size不一致的问题可能还是有麻烦的
-    this->mark_v2(objectInfo);
+    return true;
 }
 
 void GCWorker::mark_v2(const ObjectInfo& objectInfo) {
+    if constexpr (GCParameter::enableMarkPrefetch) {
+        if (enableMemoryAllocator) {
+            this->mark_with_prefetch(objectInfo);
+            return;
+        }
+    }
+    this->mark_checkpoint();
+    ObjectInfo c_objectInfo = objectInfo;
+    if (this->mark_object(c_objectInfo)) {
+        size_t local_end = this->split_scan_chunks(c_objectInfo);
+        this->scan_object(c_objectInfo, 0, local_end, [this](GCPtrBase* next_ptr) {
+            this->mark_v2(next_ptr);
+        });
+    }
+}
+
+void GCWorker::mark_with_prefetch(const ObjectInfo& objectInfo) {
+    // 以显式的标记栈代替递归，取出的对象先进入预取队列并发出预取，约markPrefetchDistance步后才真正标记和扫描，
+    // 这样访问对象头和位图时所需的缓存行大多已在途或已就绪
+    thread_local std::vector<ObjectInfo> mark_stack;
+    PrefetchQueue<ObjectInfo, GCParameter::markPrefetchDistance> prefetch_queue;
+    mark_stack.push_back(objectInfo);
+    while (true) {
+        while (!prefetch_queue.full() && !mark_stack.empty()) {
+            ObjectInfo next = mark_stack.back();
+            mark_stack.pop_back();
+            if (next.region != nullptr)
+                next.region->prefetchForMark(next.object_addr);
+            prefetch_queue.push(next);
+        }
+        if (prefetch_queue.empty()) break;
+        ObjectInfo c_objectInfo = prefetch_queue.pop();
+        this->mark_checkpoint();
+        if (this->mark_object(c_objectInfo)) {
+            size_t local_end = this->split_scan_chunks(c_objectInfo);
+            this->scan_object(c_objectInfo, 0, local_end, [this](GCPtrBase* next_ptr) {
+                ObjectInfo next;
+                if (this->visit_gcptr(next_ptr, next))
+                    mark_stack.push_back(next);
+            });
+        }
+    }
+}
+
+bool GCWorker::in_leaf_region(const ObjectInfo& objectInfo) {
+    return objectInfo.region != nullptr && objectInfo.region->isLeaf();
+}
+
+size_t GCWorker::split_scan_chunks(const ObjectInfo& objectInfo) {
+    // 并行标记期间，将超过largeObjectScanChunkSize的对象除第一块外的部分切分为扫描块放入共享队列，由空闲的标记线程协助扫描
+    // 对象在切分前已被标记，扫描期间被修改的GCPtr由删除屏障记录到SATB，因此分块扫描与整体扫描同样完整
+    // 返回当前线程应自行扫描的范围的结束偏移
+    constexpr size_t chunk_size = GCParameter::largeObjectScanChunkSize;
+    static_assert(chunk_size % sizeof(void*) == 0, "largeObjectScanChunkSize must be a multiple of pointer size");
+    if constexpr (!GCParameter::enableChunkedObjectScan)
+        return objectInfo.object_size;
+    if (objectInfo.object_size <= chunk_size || !mark_chunk_queue.isEnabled() || mark_assisting)
+        return objectInfo.object_size;      // 协助标记的应用线程不参与扫描块队列的终止检测，不可放入扫描块
+    if constexpr (GCParameter::enableLeafRegion) {
+        if (in_leaf_region(objectInfo))
+            return objectInfo.object_size;
+    }
+    for (size_t begin = chunk_size; begin < objectInfo.object_size; begin += chunk_size) {
+        mark_chunk_queue.push({objectInfo, begin, std::min(begin + chunk_size, objectInfo.object_size)});
+    }
+    return chunk_size;
+}
+
+void GCWorker::drain_mark_chunks() {
+    mark_chunk_queue.drain([this](const ScanChunk& chunk) {
+        this->scan_object(chunk.object, chunk.begin, chunk.end, [this](GCPtrBase* next_ptr) {
+            this->mark_v2(next_ptr);
+        });
+    });
+}
+
+bool GCWorker::mark_object(ObjectInfo& objectInfo) {
     void* object_addr = objectInfo.object_addr;
-    if (object_addr == nullptr) return;
-    size_t object_size = objectInfo.object_size;
+    if (object_addr == nullptr) return false;
+    size_t& object_size = objectInfo.object_size;
     GCRegion* region = objectInfo.region;
     MarkState c_markstate = GCPhase::getCurrentMarkState();
 
@@ -165,12 +273,12 @@ void GCWorker::mark_v2(const ObjectInfo& objectInfo) {
         auto it = object_map.find(object_addr);
         if (it == object_map.end()) {
             std::clog << "Warning: Object not found at " << object_addr << std::endl;
-            return;
+            return false;
         }
         read_lock.unlock();
 
         if (c_markstate == it->second.markState)    // 标记过了
-            return;
+            return false;
         it->second.markState = c_markstate;
         if (object_size != it->second.objectSize) {
             std::clog << "Warning: Object size doesn't equal, " << object_size << " vs " << it->second.objectSize << std::endl;
@@ -182,34 +290,59 @@ void GCWorker::mark_v2(const ObjectInfo& objectInfo) {
                       "&region=" << (void*) region << ", isEvacuated=" << (region == nullptr ? -1 : region->isEvacuated()) <<
                       ", object_addr=" << object_addr << ", object_size=" << object_size << std::endl;
             throw std::logic_error("GCWorker::mark_v2(): Evacuated region or out of range");
-            return;
         }
-        if (region->marked(object_addr)) return;
-        region->mark(object_addr, object_size);
+        if (region->marked(object_addr)) return false;
+        size_t marked_size = region->mark(object_addr, object_size);
+        if (marked_size != 0) {
+            if constexpr (GCParameter::enableMarkAssist)
+                marked_bytes += marked_size;
+            if constexpr (GCParameter::useLiveBytesCache)
+                getLiveBytesCache()->add(region, marked_size);
+            else
+                region->addLiveSize(marked_size);
+        }
     }
+    return true;
+}
 
-    constexpr int SIZEOF_GCPTR = sizeof(void*) == 8 ? 72 : 44;
-    constexpr int vfptr_size = sizeof(void*);
-    char* cptr = reinterpret_cast<char*>(object_addr);
-    for (char* n_addr = cptr; n_addr <= cptr + object_size - SIZEOF_GCPTR; n_addr += sizeof(void*)) {
-        int identifier_head = *(reinterpret_cast<int*>(n_addr + vfptr_size));
-        if (identifier_head == GCPTR_IDENTIFIER_HEAD) {
-            constexpr auto _max = [](int x, int y) constexpr { return x > y ? x : y; };
-            constexpr int tail_offset =
-                sizeof(int) + sizeof(MarkState) + sizeof(size_t) + sizeof(void*) + sizeof(unsigned int) + _max(sizeof(bool), 4) +
-                sizeof(std::shared_ptr<GCRegion>) + sizeof(std::unique_ptr<IReadWriteLock>);
-            char* tail_addr = n_addr + vfptr_size + tail_offset;
-            int identifier_tail = *(reinterpret_cast<int*>(tail_addr));
-            if (identifier_tail == GCPTR_IDENTIFIER_TAIL) {
-                GCPtrBase* next_ptr = reinterpret_cast<GCPtrBase*>(n_addr);
-                mark_v2(next_ptr);
-            } else {
-                std::clog << "Warning: Identifier head found at " << (void*) n_addr << " but not found tail, skipped." << std::endl;
-            }
+LiveBytesCache* GCWorker::getLiveBytesCache() {
+    // 线程退出时归还其缓存，否则协助标记的应用线程频繁创建退出时缓存列表会无限增长
+    struct CacheOwner {
+        GCWorker* worker = nullptr;
+        LiveBytesCache* cache = nullptr;
+
+        ~CacheOwner() {
+            if (cache != nullptr)
+                worker->releaseLiveBytesCache(cache);
         }
+    };
+    thread_local CacheOwner owner;
+    if (owner.cache == nullptr) {
+        std::unique_ptr<LiveBytesCache> cache = std::make_unique<LiveBytesCache>();
+        owner.worker = this;
+        owner.cache = cache.get();
+        std::unique_lock<std::mutex> lock(live_bytes_caches_mutex);
+        live_bytes_caches.emplace_back(std::move(cache));
+    }
+    return owner.cache;
+}
+
+void GCWorker::releaseLiveBytesCache(LiveBytesCache* cache) {
+    std::unique_lock<std::mutex> lock(live_bytes_caches_mutex);
+    cache->flush();     // 尚未汇总的存活字节数直接累加回region，结果与标记结束后统一汇总时一致
+    auto it = std::find_if(live_bytes_caches.begin(), live_bytes_caches.end(),
+                           [cache](const std::unique_ptr<LiveBytesCache>& c) { return c.get() == cache; });
+    if (it != live_bytes_caches.end()) {
+        std::swap(*it, live_bytes_caches.back());
+        live_bytes_caches.pop_back();
     }
 }
 
+void GCWorker::flushLiveBytesCaches() {
+    std::unique_lock<std::mutex> lock(live_bytes_caches_mutex);
+    for (auto& cache : live_bytes_caches)
+        cache->flush();
+}
 
 void GCWorker::GCThreadLoop() {
     GCUtil::sleep(0.1);
@@ -222,18 +355,26 @@ void GCWorker::GCThreadLoop() {
         if (stop_) break;
         {
             startGC();
+            GCCpuBudget::beginCycle();
             auto start_time_gc = std::chrono::high_resolution_clock::now();
             beginMark();
+            if constexpr (GCParameter::enableSATBPreClean)
+                preCleanSATB();
+            // 协助标记的应用线程位于临界区内，进入重标记的STW前必然完成
+            mark_assist_enabled.store(false);
             GCUtil::stop_the_world(GCPhase::getSTWLock(), threadPool.get(), GCParameter::suspendThreadsWhenSTW);
+            GCCpuBudget::suspend();
             auto start_time_stw = std::chrono::high_resolution_clock::now();
             triggerSATBMark();
             selectRelocationSet();
             auto end_time_stw = std::chrono::high_resolution_clock::now();
             auto duration_stw = std::chrono::duration_cast<std::chrono::microseconds>(end_time_stw - start_time_stw);
             std::clog << "STW duration: " << std::dec << duration_stw.count() << " us" << std::endl;
+            GCCpuBudget::resume();
             GCUtil::resume_the_world(GCPhase::getSTWLock());
             beginSweep();
             endGC();
+            GCCpuBudget::endCycle();
             auto end_time_gc = std::chrono::high_resolution_clock::now();
             auto duration_gc = std::chrono::duration_cast<std::chrono::milliseconds>(end_time_gc - start_time_gc);
             std::clog << "GC duration: " << std::dec << duration_gc.count() << " ms" << std::endl;
@@ -263,6 +404,13 @@ void GCWorker::wakeUpGCThread() {
 void GCWorker::triggerGC() {
     if (enableConcurrentMark) {
         wakeUpGCThread();
+    } else if (GCParameter::enableIncrementalGC && enableMemoryAllocator) {
+        // 只开始新一轮GC并获取根，后续工作由gc::step()分片完成
+        std::unique_lock<std::mutex> lock(incremental_mutex);
+        if (GCPhase::getGCPhase() == eGCPhase::NONE) {
+            startGC();
+            beginIncrementalMark();
+        }
     } else {
         startGC();
         beginMark();
@@ -273,9 +421,154 @@ void GCWorker::triggerGC() {
     }
 }
 
-std::pair<void*, std::shared_ptr<GCRegion>> GCWorker::allocate(size_t size) {
+bool GCWorker::step(std::chrono::microseconds budget) {
+    if (enableConcurrentMark || !GCParameter::enableIncrementalGC || !enableMemoryAllocator) {
+        std::clog << "Warning: gc::step() requires incremental GC, memory allocator enabled and concurrent GC disabled" << std::endl;
+        return false;
+    }
+    thread_local bool stepping = false;
+    if (stepping) return true;      // 推进GC的过程中再次调用，如清扫时析构函数中又分配了对象
+    std::unique_lock<std::mutex> lock(incremental_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return true;     // 其它线程正在推进
+    stepping = true;
+    struct SteppingGuard {
+        bool& stepping;
+
+        ~SteppingGuard() { stepping = false; }
+    } stepping_guard{stepping};
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    while (true) {
+        switch (GCPhase::getGCPhase()) {
+            case eGCPhase::NONE:
+                return false;
+            case eGCPhase::CONCURRENT_MARK:
+                if (!incrementalMark(deadline))
+                    finishIncrementalMark();
+                break;
+            case eGCPhase::SWEEP:
+                if (!memoryAllocator->incrementalSweepStep()) {
+                    endGC();
+                    return false;
+                }
+                break;
+            default:
+                std::clog << "Warning: Invalid phase for incremental GC: " << GCPhase::getGCPhaseString() << std::endl;
+                return false;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+            return true;
+    }
+}
+
+void GCWorker::beginIncrementalMark() {
+    root_object_snapshot.clear();
+    incremental_mark_stack.clear();
+    incremental_root_cursor = 0;
+    incremental_roots_done = false;
+    if constexpr (GCParameter::useArrayAsRootSet && !GCParameter::useThreadLocalRootSet) {
+        std::unique_lock<std::mutex> lock(gcRootsetMtx);
+        gcRootSet->beginChunkedScan();
+    }
+    if (stackScanner != nullptr)
+        this->mark_stack_roots(false);
+}
+
+bool GCWorker::incrementalMarkRoots() {
+    // 每次只获取一部分根：一个哈希池、一个线程根集合分段或一块根集合，返回是否还有剩余
+    if constexpr (!GCParameter::useArrayAsRootSet) {
+        if (incremental_root_cursor >= poolCount) return false;
+        int i = incremental_root_cursor++;
+        std::shared_lock<std::shared_mutex> read_lock(this->root_set_mutex[i]);
+        if constexpr (GCParameter::deferRemoveRoot) {
+            for (auto& [gcptr, removed] : root_map[i]) {
+                if (!removed)
+                    this->mark_root(gcptr);
+            }
+        } else {
+            for (GCPtrBase* gcptr : root_set[i])
+                this->mark_root(gcptr);
+        }
+        return true;
+    } else if constexpr (GCParameter::useThreadLocalRootSet) {
+        if (incremental_root_cursor >= gcThreadRootSet->getSegmentCount()) return false;
+        gcThreadRootSet->scanSegment(incremental_root_cursor++, GCParameter::rootSnapshotChunkSize, [this](GCPtrBase* c_root) {
+            this->mark_root(c_root);
+        });
+        return true;
+    } else {
+        std::unique_lock<std::mutex> lock(gcRootsetMtx);
+        return !gcRootSet->scanChunk(GCParameter::rootSnapshotChunkSize, [this](GCPtrBase* c_root) {
+            this->mark_root(c_root);
+        });
+    }
+}
+
+bool GCWorker::incrementalMark(std::chrono::steady_clock::time_point deadline) {
+    // 根与对象交替处理，标记栈与SATB均为空时标记结束，返回false
+    constexpr int CHECK_INTERVAL = 64;
+    int processed = 0;
+    while (true) {
+        if (incremental_mark_stack.empty()) {
+            if (!root_object_snapshot.empty()) {
+                incremental_mark_stack.insert(incremental_mark_stack.end(), root_object_snapshot.begin(), root_object_snapshot.end());
+                root_object_snapshot.clear();
+            } else if (!incremental_roots_done) {
+                incremental_roots_done = !incrementalMarkRoots();
+            } else if (!drainSATBInto(incremental_mark_stack)) {
+                return false;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) return true;
+            continue;
+        }
+        ObjectInfo c_objectInfo = incremental_mark_stack.back();
+        incremental_mark_stack.pop_back();
+        if (this->mark_object(c_objectInfo)) {
+            this->scan_object(c_objectInfo, [this](GCPtrBase* next_ptr) {
+                ObjectInfo next;
+                if (this->visit_gcptr(next_ptr, next))
+                    incremental_mark_stack.push_back(next);
+            });
+        }
+        if (++processed % CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline)
+            return true;
+    }
+}
+
+bool GCWorker::drainSATBInto(std::vector<ObjectInfo>& mark_stack) {
+    bool drained = false;
+    for (int i = 0; i < poolCount; i++) {
+        std::unique_lock<std::mutex> lock(satb_queue_pool_mutex[i]);
+        if (satb_queue_pool[i].empty()) continue;
+        mark_stack.insert(mark_stack.end(), satb_queue_pool[i].begin(), satb_queue_pool[i].end());
+        satb_queue_pool[i].clear();
+        drained = true;
+    }
+    return drained;
+}
+
+void GCWorker::finishIncrementalMark() {
+    // 标记栈已清空，短暂暂停应用线程，处理最后剩余的SATB并选择转移集合
+    GCUtil::stop_the_world(GCPhase::getSTWLock(), nullptr, false);
+    GCPhase::SwitchToNextPhase();   // remark
+    while (drainSATBInto(incremental_mark_stack)) {
+        while (!incremental_mark_stack.empty()) {
+            ObjectInfo c_objectInfo = incremental_mark_stack.back();
+            incremental_mark_stack.pop_back();
+            this->mark_v2(c_objectInfo);
+        }
+    }
+    selectRelocationSet();
+    GCUtil::resume_the_world(GCPhase::getSTWLock());
+    memoryAllocator->beginIncrementalSweep(enableRelocation);
+}
+
+std::pair<void*, std::shared_ptr<GCRegion>> GCWorker::allocate(size_t size, bool leaf) {
     if (!enableMemoryAllocator) return std::make_pair(nullptr, nullptr);
-    return memoryAllocator->allocate(size);
+    if constexpr (GCParameter::enableMarkAssist) {
+        if (mark_assist_enabled.load(std::memory_order_relaxed))
+            this->assistMark(size);
+    }
+    return memoryAllocator->allocate(size, leaf);
 }
 
 void GCWorker::registerObject(void* object_addr, size_t object_size) {
@@ -324,6 +617,8 @@ void GCWorker::addRoot(GCPtrBase* from) {
             root_map[poolIdx].insert_or_assign(from, false);
         else
             root_set[poolIdx].insert(from);
+    } else if constexpr (GCParameter::useThreadLocalRootSet) {
+        gcThreadRootSet->add(from);
     } else {
         std::unique_lock<std::mutex> lock(gcRootsetMtx);
         gcRootSet->add(from);
@@ -365,12 +660,28 @@ void GCWorker::removeRoot(GCPtrBase* from) {
                 std::cerr << "Warning: Root not found when erasing" << std::endl;
             }
         }
+    } else if constexpr (GCParameter::useThreadLocalRootSet) {
+        gcThreadRootSet->remove(from);
     } else {
         std::unique_lock<std::mutex> lock(gcRootsetMtx);
         gcRootSet->remove(from);
     }
 }
 
+void GCWorker::addRootFrame(GCRootFrame* frame) {
+    if constexpr (GCParameter::useArrayAsRootSet && GCParameter::useThreadLocalRootSet) {
+        gcThreadRootSet->addFrame(frame);
+    } else {
+        throw std::logic_error("GCWorker::addRootFrame(): Root frame requires thread-local root set");
+    }
+}
+
+void GCWorker::removeRootFrame(GCRootFrame* frame) {
+    if constexpr (GCParameter::useArrayAsRootSet && GCParameter::useThreadLocalRootSet) {
+        gcThreadRootSet->removeFrame(frame);
+    }
+}
+
 void GCWorker::addSATB(void* object_addr) {
     std::unique_lock<std::mutex> lock(this->satb_queue_mutex);
     satb_queue.push_back(object_addr);
@@ -396,12 +707,12 @@ void GCWorker::addSATB(const ObjectInfo& objectInfo) {
     }
 }
 
-void GCWorker::registerDestructor(void* object_addr, const std::function<void(void*)>& destructor, GCRegion* region) {
+void GCWorker::registerType(void* object_addr, GCTypeRegistry::TypeId type_id, GCRegion* region) {
     if (region == nullptr) {
         std::unique_lock<std::mutex> lock(this->destructor_map_mutex);
-        this->destructor_map.emplace(object_addr, destructor);
+        this->destructor_map.emplace(object_addr, GCTypeRegistry::getDescriptor(type_id));
     } else {
-        region->registerDestructor(object_addr, destructor);
+        region->setTypeId(object_addr, type_id);
     }
 }
 
@@ -410,6 +721,13 @@ void GCWorker::startGC() {
         GCPhase::SwitchToNextPhase();
         if (enableMemoryAllocator)
             memoryAllocator->flushRegionMapBuffer();
+        if constexpr (GCParameter::adaptiveGCThreadCount) {
+            // CPU亲和性和cgroup配额可能在运行期间变化，每轮GC开始时刷新可用的GC线程数
+            if (enableParallelGC) {
+                gcThreadLimit = std::min(gcThreadCount, GCUtil::getAvailableCPUCount());
+                memoryAllocator->setGCThreadCount(gcThreadLimit);
+            }
+        }
 
         if (enableConcurrentMark)
             GCUtil::sleep(0.1);       // 防止gc root尚未来得及加入root_set
@@ -471,6 +789,8 @@ void GCWorker::beginMark() {
                 }
             }
         }
+        if (stackScanner != nullptr)
+            this->mark_stack_roots(false);
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
         std::clog << "Root set lock duration: " << std::dec << duration.count() << " us" << std::endl;
@@ -481,83 +801,156 @@ void GCWorker::beginMark() {
                 this->mark(ptr);
             }
         } else {
-            if (!enableParallelGC) {
-                for (const ObjectInfo& objectInfo : this->root_object_snapshot) {
-                    this->mark_v2(objectInfo);
-                }
-            } else {
-                for (int i = 0; i < gcThreadCount; i++) {
-                    threadPool->execute([this, i] {
-                        size_t startIndex, endIndex;
-                        getParallelIndex(i, root_object_snapshot, startIndex, endIndex);
-                        for (size_t j = startIndex; j < endIndex; j++) {
-                            this->mark_v2(root_object_snapshot[j]);
-                        }
-                    });
-                }
-                threadPool->waitForTaskComplete(gcThreadCount);
-            }
+            this->mark_root_snapshot();
         }
 
     } else {
         // mark root
         bool parallel_markroot = false;
-        {
-            std::unique_lock<std::mutex> lock(gcRootsetMtx);
-            const size_t ROOT_SET_PARALLEL_THRESHOLD = 5000;
-            if (enableParallelGC && gcRootSet->getSize() >= ROOT_SET_PARALLEL_THRESHOLD) {
+        const size_t ROOT_SET_PARALLEL_THRESHOLD = 5000;
+        if constexpr (GCParameter::useThreadLocalRootSet) {
+            // 逐个分段与其所属线程握手获取根快照，不阻塞其它线程增删根
+            int segmentCount = gcThreadRootSet->getSegmentCount();
+            if (enableParallelGC && segmentCount > 1 && gcThreadRootSet->getSize() >= ROOT_SET_PARALLEL_THRESHOLD) {
                 parallel_markroot = true;
-                std::vector<std::unique_ptr<Iterator<GCPtrBase*>>> iterators = gcRootSet->getIterators(gcThreadCount);
-                for (int i = 0; i < gcThreadCount; i++) {
-                    Iterator<GCPtrBase*>* iterator = iterators[i].get();
-                    threadPool->execute([this, i, iterator] {
-                        while (iterator->MoveNext()) {
-                            GCPtrBase* c_root = iterator->current();
-                            this->mark_root(c_root, i);
+                int workers = std::min(gcThreadLimit, segmentCount);
+                for (int i = 0; i < workers; i++) {
+                    threadPool->execute([this, i, segmentCount, workers] {
+                        for (int j = i; j < segmentCount; j += workers) {
+                            gcThreadRootSet->scanSegment(j, GCParameter::rootSnapshotChunkSize, [this, i](GCPtrBase* c_root) {
+                                this->mark_root(c_root, i);
+                            });
                         }
                     });
                 }
-                threadPool->waitForTaskComplete(gcThreadCount);
+                threadPool->waitForTaskComplete(workers);
             } else {
-                std::unique_ptr<Iterator<GCPtrBase*>> iterator = gcRootSet->getIterator();
-                while (iterator->MoveNext()) {
-                    GCPtrBase* c_root = iterator->current();
-                    this->mark_root(c_root);
+                for (int j = 0; j < segmentCount; j++) {
+                    gcThreadRootSet->scanSegment(j, GCParameter::rootSnapshotChunkSize, [this](GCPtrBase* c_root) {
+                        this->mark_root(c_root);
+                    });
                 }
             }
+        } else {
+            // 分块获取根快照：每次持锁只处理rootSnapshotChunkSize个根，块之间释放锁，GCPtr的构造和析构被阻塞的时间与根集合大小无关
+            // 块之间被移入已扫描区域的根由根集合记录并在下一块补扫，移出的根则已经过删除屏障，因此快照与一次性获取时同样完整
+            // 快照本身开销很小，串行获取即可，之后的并发标记仍按快照并行进行
+            {
+                std::unique_lock<std::mutex> lock(gcRootsetMtx);
+                gcRootSet->beginChunkedScan();
+            }
+            bool finished = false;
+            while (!finished) {
+                std::unique_lock<std::mutex> lock(gcRootsetMtx);
+                finished = gcRootSet->scanChunk(GCParameter::rootSnapshotChunkSize, [this](GCPtrBase* c_root) {
+                    this->mark_root(c_root);
+                });
+            }
         }
+        if (stackScanner != nullptr)
+            this->mark_stack_roots(parallel_markroot);
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
         std::clog << "Root set lock duration: " << std::dec << duration.count() << " us" << std::endl;
 
         // mark others
-        if (!enableParallelGC) {
-            for (const ObjectInfo& objectInfo : this->root_object_snapshot) {
-                this->mark_v2(objectInfo);
-            }
-        } else {
-            if (parallel_markroot) {
-                for (int i = 0; i < gcThreadCount; i++) {
-                    threadPool->execute([this, i] {
-                        for (const ObjectInfo& objectInfo : root_object_snapshots[i]) {
-                            this->mark_v2(objectInfo);
-                        }
-                    });
-                }
-            } else {
-                for (int i = 0; i < gcThreadCount; i++) {
-                    threadPool->execute([this, i] {
-                        size_t startIndex, endIndex;
-                        getParallelIndex(i, root_object_snapshot, startIndex, endIndex);
-                        for (size_t j = startIndex; j < endIndex; j++) {
-                            this->mark_v2(root_object_snapshot[j]);
-                        }
-                    });
-                }
+        if (parallel_markroot) {
+            // 各GC线程分别获取的根快照合并为一个，以便按批动态领取
+            for (int i = 0; i < gcThreadCount; i++) {
+                root_object_snapshot.insert(root_object_snapshot.end(), root_object_snapshots[i].begin(), root_object_snapshots[i].end());
             }
-            threadPool->waitForTaskComplete(gcThreadCount);
+        }
+        this->mark_root_snapshot();
+    }
+}
+
+bool GCWorker::mark_root_batch() {
+    constexpr size_t ROOT_MARK_BATCH_SIZE = 64;
+    size_t total = root_object_snapshot.size();
+    size_t startIndex = root_mark_cursor.fetch_add(ROOT_MARK_BATCH_SIZE);
+    if (startIndex >= total) return false;
+    size_t endIndex = std::min(startIndex + ROOT_MARK_BATCH_SIZE, total);
+    for (size_t j = startIndex; j < endIndex; j++) {
+        this->mark_v2(root_object_snapshot[j]);
+    }
+    return true;
+}
+
+void GCWorker::mark_root_snapshot() {
+    // 根快照按批领取而不是预先均分：GC线程之间动态分摊负载，并发标记期间正在分配内存的应用线程也可以领取以协助标记
+    root_mark_cursor.store(0);
+    if constexpr (GCParameter::enableMarkAssist) {
+        if (enableConcurrentMark) {
+            mark_assist_cycle.fetch_add(1);
+            mark_assist_enabled.store(true);    // 直至并发标记阶段结束，包括根快照领取完之后的SATB预清理
         }
     }
+    if (!enableParallelGC) {
+        while (this->mark_root_batch());
+    } else {
+        int workers = getMarkWorkerCount(root_object_snapshot.size());
+        mark_chunk_queue.begin(workers);
+        for (int i = 0; i < workers; i++) {
+            threadPool->execute([this] {
+                while (this->mark_root_batch());
+                this->drain_mark_chunks();
+            });
+        }
+        threadPool->waitForTaskComplete(workers);
+        mark_chunk_queue.end();
+    }
+}
+
+void GCWorker::assistMark(size_t size) {
+    // 并发标记期间，应用线程每分配一个字节就欠下markAssistRatio字节的标记工作；欠账超过阈值时领取标记工作，
+    // 新标记的字节数用于偿还欠账。分配越快的线程承担越多的标记，使标记能在分配高峰下按时完成
+    // 暂时无工作可领取时欠账留到下次分配时继续偿还；欠账超过markAssistMaxDebt时等待至领到工作或并发标记结束，使堆的超额增长有上界
+    unsigned int cycle = mark_assist_cycle.load(std::memory_order_relaxed);
+    if (mark_assist_cycle_seen != cycle) {
+        mark_assist_cycle_seen = cycle;
+        mark_assist_debt = 0;
+    }
+    mark_assist_debt += static_cast<size_t>(static_cast<float>(size) * GCParameter::markAssistRatio);
+    if (mark_assist_debt < GCParameter::markAssistThreshold || mark_assisting) return;
+    mark_assisting = true;
+    size_t start_bytes = marked_bytes;
+    while (marked_bytes - start_bytes < mark_assist_debt) {
+        if (this->assist_mark_step()) continue;
+        if (!mark_assist_enabled.load(std::memory_order_relaxed)) break;
+        if (mark_assist_debt - (marked_bytes - start_bytes) <= GCParameter::markAssistMaxDebt) break;
+        std::this_thread::yield();
+    }
+    size_t paid = marked_bytes - start_bytes;
+    if (paid >= mark_assist_debt || !mark_assist_enabled.load(std::memory_order_relaxed))
+        mark_assist_debt = 0;       // 还清欠账，或并发标记已结束
+    else
+        mark_assist_debt -= paid;
+    mark_assisting = false;
+}
+
+bool GCWorker::assist_mark_step() {
+    // 依次从根快照、并行标记的扫描块队列、本线程所在分组的SATB缓冲区领取工作；GC线程私有标记栈中的工作无法领取
+    if (this->mark_root_batch())
+        return true;
+    bool scanned = mark_chunk_queue.tryHelp([this](const ScanChunk& chunk) {
+        this->scan_object(chunk.object, chunk.begin, chunk.end, [this](GCPtrBase* next_ptr) {
+            this->mark_v2(next_ptr);
+        });
+    });
+    if (scanned)
+        return true;
+    static thread_local std::vector<ObjectInfo> satb_batch;
+    int poolIdx = getPoolIdx();
+    {
+        std::unique_lock<std::mutex> lock(satb_queue_pool_mutex[poolIdx]);
+        if (satb_queue_pool[poolIdx].empty()) return false;
+        satb_batch.swap(satb_queue_pool[poolIdx]);
+    }
+    // 与SATB预清理相同，并发标记期间被标记的SATB对象无需在重标记时再次处理
+    for (const ObjectInfo& objectInfo : satb_batch)
+        this->mark_v2(objectInfo);
+    satb_batch.clear();
+    return true;
 }
 
 void GCWorker::mark_root(GCPtrBase* gcptr, int root_snapshots_index) {
@@ -576,22 +969,27 @@ void GCWorker::mark_root(GCPtrBase* gcptr, int root_snapshots_index) {
         root_object_snapshot.emplace_back(objectInfo);
 }
 
+void GCWorker::mark_stack_roots(bool parallel_markroot) {
+    // 栈上的GCPtr未加入根集合，扫描各线程栈找到其引用的对象
+    stack_root_snapshot.clear();
+    stackScanner->scanStacks(stack_root_snapshot);
+    for (size_t i = 0; i < stack_root_snapshot.size(); i++) {
+        if (parallel_markroot)
+            root_object_snapshots[i % gcThreadCount].emplace_back(stack_root_snapshot[i]);
+        else
+            root_object_snapshot.emplace_back(stack_root_snapshot[i]);
+    }
+}
+
 void GCWorker::triggerSATBMark() {
     if (GCPhase::getGCPhase() == eGCPhase::CONCURRENT_MARK) {
         GCPhase::SwitchToNextPhase();   // remark
         if (!enableConcurrentMark) return;
         if (!enableMemoryAllocator) {
             if (enableParallelGC) {
-                for (int i = 0; i < gcThreadCount; i++) {
-                    threadPool->execute([this, i] {
-                        size_t startIndex, endIndex;
-                        getParallelIndex(i, satb_queue, startIndex, endIndex);
-                        for (size_t j = startIndex; j < endIndex; j++) {
-                            this->mark(satb_queue[j]);
-                        }
-                    });
-                }
-                threadPool->waitForTaskComplete(gcThreadCount);
+                GCUtil::parallel_for(threadPool.get(), getMarkWorkerCount(satb_queue.size()), satb_queue.size(), [this](size_t j) {
+                    this->mark(satb_queue[j]);
+                });
             } else {
                 for (auto object_addr : satb_queue) {
                     mark(object_addr);
@@ -599,26 +997,10 @@ void GCWorker::triggerSATBMark() {
             }
             satb_queue.clear();
         } else {
-            for (int i = 0; i < poolCount; i++) {
-                if (satb_queue_pool[i].empty()) continue;
-                if (enableParallelGC) {
-                    for (int tid = 0; tid < gcThreadCount; tid++) {
-                        threadPool->execute([this, i, tid] {
-                            size_t startIndex, endIndex;
-                            getParallelIndex(tid, satb_queue_pool[i], startIndex, endIndex);
-                            for (size_t j = startIndex; j < endIndex; j++) {
-                                this->mark_v2(satb_queue_pool[i][j]);
-                            }
-                        });
-                    }
-                    threadPool->waitForTaskComplete(gcThreadCount);
-                } else {
-                    for (auto& objectInfo : satb_queue_pool[i]) {
-                        this->mark_v2(objectInfo);
-                    }
-                }
+            // 大部分SATB已在并发预清理中处理，此处只剩少量，将所有池合并为一次并行处理
+            this->mark_satb_buffers(satb_queue_pool);
+            for (int i = 0; i < poolCount; i++)
                 satb_queue_pool[i].clear();
-            }
         }
         if constexpr (GCParameter::distinctSATB)
             satb_set.clear();
@@ -626,16 +1008,78 @@ void GCWorker::triggerSATBMark() {
         std::clog << "Warning: Already in remark phase or in other invalid phase" << std::endl;
 }
 
+void GCWorker::preCleanSATB() {
+    if (GCPhase::getGCPhase() != eGCPhase::CONCURRENT_MARK || !enableConcurrentMark || !enableMemoryAllocator) return;
+    // 在并发标记阶段反复取走已积累的SATB并标记，直到剩余量不超过阈值，剩下的留给重标记在STW中处理
+    std::vector<std::vector<ObjectInfo>> precleaning(poolCount);
+    int rounds = 0;
+    size_t precleaned = 0;
+    while (rounds < GCParameter::satbPreCleanMaxRounds) {
+        size_t pending = 0;
+        for (int i = 0; i < poolCount; i++) {
+            std::unique_lock<std::mutex> lock(satb_queue_pool_mutex[i]);
+            pending += satb_queue_pool[i].size();
+        }
+        if (pending <= GCParameter::satbPreCleanThreshold) break;
+        for (int i = 0; i < poolCount; i++) {
+            std::unique_lock<std::mutex> lock(satb_queue_pool_mutex[i]);
+            precleaning[i].swap(satb_queue_pool[i]);
+        }
+        this->mark_satb_buffers(precleaning);
+        for (int i = 0; i < poolCount; i++) {
+            precleaned += precleaning[i].size();
+            precleaning[i].clear();
+        }
+        rounds++;
+    }
+    if (rounds > 0)
+        std::clog << "SATB pre-clean: " << rounds << " rounds, " << precleaned << " entries" << std::endl;
+}
+
+void GCWorker::mark_satb_buffers(const std::vector<std::vector<ObjectInfo>>& buffers) {
+    std::vector<size_t> prefix(buffers.size() + 1, 0);
+    for (size_t i = 0; i < buffers.size(); i++)
+        prefix[i + 1] = prefix[i] + buffers[i].size();
+    size_t total = prefix.back();
+    if (total == 0) return;
+    // 将各池视为首尾相接的一个整体由GC线程按块动态领取，只需等待一次
+    auto mark_one = [this, &buffers, &prefix](size_t j) {
+        size_t i = std::upper_bound(prefix.begin(), prefix.end(), j) - prefix.begin() - 1;
+        this->mark_v2(buffers[i][j - prefix[i]]);
+    };
+    if (enableParallelGC && total >= static_cast<size_t>(gcThreadLimit)) {
+        int workers = getMarkWorkerCount(total);
+        mark_chunk_queue.begin(workers);
+        GCUtil::parallel_for(threadPool.get(), workers, total, mark_one, [this] {
+            this->drain_mark_chunks();
+        });
+        mark_chunk_queue.end();
+    } else {
+        for (size_t j = 0; j < total; j++)
+            mark_one(j);
+    }
+}
+
 void GCWorker::selectRelocationSet() {
     if (GCPhase::getGCPhase() != eGCPhase::REMARK) {
         std::clog << "Warning: Already in sweeping phase or in other invalid phase" << std::endl;
         return;
     }
+    if constexpr (GCParameter::useLiveBytesCache)
+        flushLiveBytesCaches();     // 标记已全部结束，选择转移集合前将各标记线程缓存的存活字节数汇总到region
+    if (stackScanner != nullptr && enableRelocation)
+        stackScanner->pinStackRegions();    // 线程栈上的字无法被更新，被引用的region本轮不重定位
     GCPhase::SwitchToNextPhase();
     if (!enableMemoryAllocator)
         return;
-    if (enableRelocation)
-        memoryAllocator->SelectRelocationSet();
+    if constexpr (GCParameter::enableHotColdRelocation) {
+        if (enableRelocation)
+            GCRegion::advanceAccessEpoch();     // 此后的访问计入新纪元，转移时上一纪元内被访问过的对象仍视为热对象
+    }
+    if (enableRelocation) {
+        compacting = compact_requested.exchange(false);
+        memoryAllocator->SelectRelocationSet(compacting);
+    }
     else
         memoryAllocator->SelectClearSet();
 }
@@ -671,8 +1115,11 @@ std::pair<void*, std::shared_ptr<GCRegion>> GCWorker::getHealedPointer(void* ptr
         if (region->isEvacuated()) {
             // region已被标识为需要转移，但尚未完成转移
             std::clog << "Info: Relocation done by user thread " << ptr << std::endl;
-            region->relocateObject(ptr, obj_size);
+            // 应用线程正在访问的对象必然是热对象
+            region->relocateObject(ptr, obj_size, true);
             ret = region->queryForwardingTable(ptr);
+            if (ret.first == nullptr && (region->evacuationFailed() || !region->isEvacuated()))
+                return std::make_pair(nullptr, nullptr);    // 转移失败，region将被或已被原地保留，继续使用原地址
             if (ret.first == nullptr)
                 throw std::logic_error("GCWorker::getHealedPointer(): Entry not found twice in forwarding table.");
             return ret;
@@ -684,15 +1131,56 @@ std::pair<void*, std::shared_ptr<GCRegion>> GCWorker::getHealedPointer(void* ptr
     }
 }
 
+void GCWorker::evacuateDepthFirst(const ObjectInfo& root) {
+    // 栈中每项为待转移的对象以及父对象中引用它的GCPtr（根对象为nullptr），子对象转移后再修正该GCPtr
+    static thread_local std::vector<std::pair<ObjectInfo, GCPtrBase*>> evacuation_stack;
+    static thread_local std::vector<std::pair<ObjectInfo, GCPtrBase*>> children;
+    evacuation_stack.emplace_back(root, nullptr);
+    while (!evacuation_stack.empty()) {
+        auto [objectInfo, slot] = evacuation_stack.back();
+        evacuation_stack.pop_back();
+        GCRegion* region = objectInfo.region;
+        // 只跟随到负责转移的线程已等到PtrGuard全部释放的region，单次检查use_count无法排除其后新建的PtrGuard
+        if (!region->isEvacuated() || region->isFreed() || !region->guardsDrained()) continue;
+        auto forwarded = region->queryForwardingTable(objectInfo.object_addr);
+        bool expand = false;
+        if (forwarded.first == nullptr) {
+            size_t object_size = region->getRegionType() == RegionEnum::TINY ? GCRegion::TINY_OBJECT_THRESHOLD : objectInfo.object_size;
+            region->relocateObject(objectInfo.object_addr, object_size);
+            forwarded = region->queryForwardingTable(objectInfo.object_addr);
+            expand = true;      // 已被转移过的对象不再展开，因此每个对象至多展开一次
+        }
+        if (forwarded.first == nullptr) continue;
+        // 对象已有转发表项，此时自愈只查询转发表，不会由本线程以应用线程的身份再次转移
+        if (slot != nullptr) slot->getVoidPtr();
+        if (!expand || forwarded.second->isLeaf()) continue;
+        ObjectInfo moved{forwarded.first, objectInfo.object_size, forwarded.second.get()};
+        children.clear();
+        // 读取子对象时不可自愈，否则子对象会先被读屏障转移到非待转移的region，深度优先遍历只能展开一层
+        this->scan_object(moved, [](GCPtrBase* gcptr) {
+            ObjectInfo child = gcptr->getRawObjectInfo();
+            if (child.object_addr != nullptr && child.region != nullptr)
+                children.emplace_back(child, gcptr);
+        });
+        // 逆序入栈，使第一个GCPtr成员引用的对象紧跟在当前对象之后转移
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+            evacuation_stack.push_back(*it);
+        if constexpr (GCCpuBudget::enabled) {
+            if (!mark_assisting)
+                GCCpuBudget::checkpoint();
+        }
+    }
+}
+
 void GCWorker::callDestructor(void* object_addr, bool remove_after_call) {
+    // 平凡析构的对象不会登记，找不到即无需调用
     auto destructor_it = destructor_map.find(object_addr);
     if (destructor_it != destructor_map.end()) {
-        auto& destructor = destructor_it->second;
-        destructor(object_addr);
+        const GCTypeDescriptor* descriptor = destructor_it->second;
+        if (descriptor != nullptr && descriptor->destructor != nullptr)
+            descriptor->destructor(object_addr);
         if (remove_after_call)
             destructor_map.erase(destructor_it);
-    } else {
-        std::clog << "Warning: Destructor not found for " << object_addr << std::endl;
     }
 }
 
@@ -702,6 +1190,15 @@ void GCWorker::endGC() {
         if (enableMemoryAllocator)
             memoryAllocator->resetLiveSize();
         root_object_snapshot.clear();
+        if (compacting) {
+            compacting = false;
+            {
+                std::unique_lock<std::mutex> lock(this->finished_gc_mutex);
+                compact_left_regions = memoryAllocator->getEvacuationLeftRegions();
+                compacted_cycles++;
+            }
+            finished_gc_condition.notify_all();
+        }
     } else {
         std::clog << "Warning: Not started GC, or not finished sweeping yet" << std::endl;
     }
@@ -726,9 +1223,27 @@ void GCWorker::printMap() const {
 
 bool GCWorker::is_root(void* gcptr_addr) {
     if (enableMemoryAllocator) {
+        // 栈上的GCPtr必然不在region内，先判断栈区可省去查询regionMap
+        if (GCUtil::is_stack_pointer(gcptr_addr)) {
+            if constexpr (GCParameter::useConservativeStackScan) {
+                // 栈上的GCPtr不加入根集合，由扫描线程栈找到
+                stackScanner->registerCurrentThread();
+                return false;
+            }
+            return true;
+        }
         return !memoryAllocator->inside_allocated_regions(gcptr_addr);
     } else {
+#if _WIN32 && _MSC_VER
         return GCUtil::is_stack_pointer(gcptr_addr);
+#else
+        // 没有受管内存可供区分，全局、静态的GCPtr也须视为根，不确定的一律返回true，前提是启用了析构函数
+        if constexpr (GCParameter::enableDestructorSupport) {
+            return true;
+        } else {
+            throw std::invalid_argument("GCWorker::is_root() is not supported on current system without memory allocator");
+        }
+#endif
     }
 }
 
@@ -775,4 +1290,58 @@ std::vector<GCPtrBase*> GCWorker::inside_gcptr_set(GCPtrBase* gcptr_addr, size_t
 void GCWorker::freeGCReservedMemory() {
     if (enableMemoryAllocator)
         memoryAllocator->freeReservedMemory();
+}
+
+size_t GCWorker::compact() {
+    if (!enableMemoryAllocator || !enableRelocation) {
+        std::clog << "Warning: gc::compact() requires memory allocator and relocation enabled" << std::endl;
+        return 0;
+    }
+    // 每轮转移受evacuationReserveSize限制，超出的region留给下一轮，直至全部转移或某一轮不再减少
+    size_t left_regions = compactOnce();
+    while (left_regions != 0) {
+        size_t left = compactOnce();
+        bool progressed = left < left_regions;
+        left_regions = left;
+        if (!progressed) break;
+    }
+    if (left_regions != 0) {
+        std::clog << "Info: gc::compact() left " << left_regions
+                  << " regions in place, limited by evacuationReserveSize" << std::endl;
+    }
+    // 已转移region中对象的析构函数执行完毕后，其内存才经终结器线程归还
+    if (finalizer != nullptr)
+        finalizer->waitUntilIdle();
+    memoryAllocator->freeReservedMemory();
+    GCUtil::releaseFreeMemoryToOS();
+    return left_regions;
+}
+
+size_t GCWorker::compactOnce() {
+    unsigned int target;
+    {
+        std::unique_lock<std::mutex> lock(this->finished_gc_mutex);
+        target = compacted_cycles + 1;
+    }
+    // 正在进行的一轮GC可能已选择完转移集合，此时请求留给下一轮
+    compact_requested.store(true);
+    auto compacted = [this, target] {
+        std::unique_lock<std::mutex> lock(this->finished_gc_mutex);
+        return compacted_cycles >= target;
+    };
+    if (enableConcurrentMark) {
+        wakeUpGCThread();
+        std::unique_lock<std::mutex> lock(this->finished_gc_mutex);
+        finished_gc_condition.wait(lock, [this, target] { return compacted_cycles >= target; });
+    } else if (GCParameter::enableIncrementalGC) {
+        while (!compacted()) {
+            triggerGC();
+            while (step(std::chrono::milliseconds(10)));
+        }
+    } else {
+        while (!compacted())
+            triggerGC();
+    }
+    std::unique_lock<std::mutex> lock(this->finished_gc_mutex);
+    return compact_left_regions;
 }
\ No newline at end of file
@@ -12,10 +12,21 @@
 #include <shared_mutex>
 #include <functional>
 #include <condition_variable>
+#include <algorithm>
+#include <chrono>
 
 #include "GCPtrBase.h"
 #include "GCMemoryAllocator.h"
 #include "GCRootSet.h"
+#include "GCThreadRootSet.h"
+#include "GCStackScanner.h"
+#include "GCIdentifierScanner.h"
+#include "PrefetchQueue.h"
+#include "LiveBytesCache.h"
+#include "MarkChunkQueue.h"
+#include "GCCpuBudget.h"
+#include "GCFinalizer.h"
+#include "GCTypeDescriptor.h"
 #include "GCUtil.h"
 #include "GCParameter.h"
 #include "ObjectInfo.h"
@@ -40,6 +51,24 @@ private:
     std::vector<ObjectInfo> root_object_snapshot;
     std::vector<std::vector<ObjectInfo>> root_object_snapshots;
     std::unique_ptr<GCRootSet> gcRootSet;
+    std::unique_ptr<GCThreadRootSet> gcThreadRootSet;
+    std::vector<std::unique_ptr<LiveBytesCache>> live_bytes_caches;
+    std::mutex live_bytes_caches_mutex;
+    MarkChunkQueue mark_chunk_queue;        // 并行标记时大对象切分出的扫描块，由所有标记线程共同扫描
+    std::atomic<size_t> root_mark_cursor;   // 根快照的领取游标，GC线程与协助标记的应用线程按批领取
+    std::atomic<bool> mark_assist_enabled;  // 处于并发标记阶段，应用线程可领取标记工作以协助标记
+    std::atomic<unsigned int> mark_assist_cycle;    // 启用协助标记的轮数，用于丢弃上一轮未偿还的欠账
+    static thread_local unsigned int mark_assist_cycle_seen;
+    static thread_local size_t mark_assist_debt;    // 本线程因分配内存而欠下的标记工作量（字节），未偿还部分留到下次分配时继续偿还
+    static thread_local size_t marked_bytes;        // 本线程累计新标记的字节数，用于偿还协助标记的欠账
+    static thread_local bool mark_assisting;
+    // 增量式回收的状态
+    std::mutex incremental_mutex;
+    std::vector<ObjectInfo> incremental_mark_stack;
+    int incremental_root_cursor;
+    bool incremental_roots_done;
+    std::unique_ptr<GCStackScanner> stackScanner;
+    std::vector<ObjectInfo> stack_root_snapshot;
     std::mutex gcRootsetMtx;
     std::vector<void*> satb_queue;
     int poolCount;
@@ -49,7 +78,7 @@ private:
     std::unordered_set<void*> satb_set;
     std::unique_ptr<std::set<GCPtrBase*>> gcPtrSet;
     std::unique_ptr<std::shared_mutex> gcPtrSetMtx;
-    std::unordered_map<void*, std::function<void(void*)>> destructor_map;
+    std::unordered_map<void*, const GCTypeDescriptor*> destructor_map;     // 未启用内存分配器时对象的类型描述符
     std::mutex destructor_map_mutex;
     std::mutex thread_mutex;
     std::mutex finished_gc_mutex;
@@ -58,7 +87,13 @@ private:
     std::unique_ptr<std::thread> gc_thread;
     std::unique_ptr<GCMemoryAllocator> memoryAllocator;
     std::unique_ptr<ThreadPoolExecutor> threadPool;
+    std::unique_ptr<GCFinalizer> finalizer;     // 终结器线程，须先于内存分配器析构
+    std::atomic<bool> compact_requested;        // gc::compact()请求下一轮GC进行整理
+    bool compacting;                            // 本轮GC为整理，由选择转移集合时取得请求
+    unsigned int compacted_cycles;              // 已完成的整理轮数，由finished_gc_mutex保护
+    size_t compact_left_regions;                // 最近一轮整理受转移预留空间限制而留在原地的region数，由finished_gc_mutex保护
     int gcThreadCount;
+    int gcThreadLimit;          // 本轮GC可用的GC线程数，启用adaptiveGCThreadCount时每轮开始按可用CPU数刷新
     bool enableConcurrentMark, enableParallelGC, enableMemoryAllocator, useInlineMarkstate,
         enableRelocation, enableDestructorSupport;
     volatile bool stop_, ready_;
@@ -69,34 +104,118 @@ private:
 
     void mark_v2(const ObjectInfo&);
 
+    bool visit_gcptr(GCPtrBase*, ObjectInfo&);
+
+    bool mark_object(ObjectInfo&);
+
+    void mark_with_prefetch(const ObjectInfo&);
+
+    size_t split_scan_chunks(const ObjectInfo&);
+
+    // 标记循环中的CPU预算检查点；协助标记的应用线程不受GC的CPU预算限制
+    void mark_checkpoint() {
+        if constexpr (GCCpuBudget::enabled) {
+            if (!mark_assisting)
+                GCCpuBudget::checkpoint();
+        }
+    }
+
+    bool mark_root_batch();
+
+    int getMarkWorkerCount(size_t objects) const {
+        return GCUtil::getWorkerCount(objects, GCParameter::minObjectsPerGCThread, gcThreadLimit);
+    }
+
+    void mark_root_snapshot();
+
+    // 请求并等待一轮整理式GC完成，返回其中留在原地的region数
+    size_t compactOnce();
+
+    void assistMark(size_t size);
+
+    bool assist_mark_step();
+
+    void drain_mark_chunks();
+
+    LiveBytesCache* getLiveBytesCache();
+
+    void releaseLiveBytesCache(LiveBytesCache*);
+
+    void flushLiveBytesCaches();
+
+    // GCRegion在此头文件中为不完整类型，须在GCWorker.cpp中定义
+    static bool in_leaf_region(const ObjectInfo&);
+
+    // 查找对象内的所有GCPtr，对每个头尾标识均吻合的GCPtr调用func；叶子region中的对象不含GCPtr，不读取其内容
+    template<typename Func>
+    void scan_object(const ObjectInfo& objectInfo, Func&& func) {
+        this->scan_object(objectInfo, 0, objectInfo.object_size, std::forward<Func>(func));
+    }
+
+    // 只查找标识头位于对象内[begin, end)偏移范围的GCPtr，begin须按指针大小对齐；用于将大对象切分为多个扫描块
+    template<typename Func>
+    void scan_object(const ObjectInfo& objectInfo, size_t begin, size_t end, Func&& func) {
+        constexpr int SIZEOF_GCPTR = sizeof(void*) == 8 ? 72 : 44;
+        constexpr int vfptr_size = sizeof(void*);
+        if (objectInfo.object_size < SIZEOF_GCPTR || begin >= end) return;
+        if constexpr (GCParameter::enableLeafRegion) {
+            if (in_leaf_region(objectInfo)) return;
+        }
+        size_t last_offset = std::min(end - 1, objectInfo.object_size - SIZEOF_GCPTR);
+        if (begin > last_offset) return;
+        char* cptr = reinterpret_cast<char*>(objectInfo.object_addr);
+        char* last_addr = cptr + last_offset;
+        constexpr GCIdentifierScanner::FindFunc find_next =
+                GCParameter::useSIMDIdentifierScan ? &GCIdentifierScanner::findNext : &GCIdentifierScanner::findNextScalar;
+        for (char* n_addr = find_next(cptr + begin, last_addr); n_addr != nullptr; n_addr = find_next(n_addr + vfptr_size, last_addr)) {
+            constexpr auto _max = [](int x, int y) constexpr { return x > y ? x : y; };
+            constexpr int tail_offset =
+                sizeof(int) + sizeof(MarkState) + sizeof(size_t) + sizeof(void*) + sizeof(unsigned int) + _max(sizeof(bool), 4) +
+                sizeof(std::shared_ptr<GCRegion>) + sizeof(std::unique_ptr<IReadWriteLock>);
+            char* tail_addr = n_addr + vfptr_size + tail_offset;
+            int identifier_tail = *(reinterpret_cast<int*>(tail_addr));
+            if (identifier_tail == GCPTR_IDENTIFIER_TAIL) {
+                func(reinterpret_cast<GCPtrBase*>(n_addr));
+            } else {
+                std::clog << "Warning: Identifier head found at " << (void*) n_addr << " but not found tail, skipped." << std::endl;
+            }
+        }
+    }
+
     void mark_root(GCPtrBase* gcptr, int root_snapshots_index = -1);
 
+    void mark_stack_roots(bool parallel_markroot);
+
     void GCThreadLoop();
 
     void callDestructor(void*, bool remove_after_call = false);
 
-    template<typename U>
-    void getParallelIndex(int tid, const std::vector<U>& vec, size_t& startIndex, size_t& endIndex) {
-        size_t snum = vec.size() / gcThreadCount;
-        startIndex = tid * snum;
-        if (tid == gcThreadCount - 1)
-            endIndex = vec.size();
-        else
-            endIndex = (tid + 1) * snum;
-    }
-
     void startGC();
 
     void beginMark();
 
     void triggerSATBMark();
 
+    void preCleanSATB();
+
+    void mark_satb_buffers(const std::vector<std::vector<ObjectInfo>>&);
+
     void beginSweep();
 
     void selectRelocationSet();
 
     void endGC();
 
+    void beginIncrementalMark();
+
+    bool incrementalMarkRoots();
+
+    bool incrementalMark(std::chrono::steady_clock::time_point deadline);
+
+    bool drainSATBInto(std::vector<ObjectInfo>&);
+
+    void finishIncrementalMark();
+
     int getPoolIdx() const {
         if (poolCount == 1) return 0;
         return GCUtil::getPoolIdx(poolCount);
@@ -123,7 +242,20 @@ public:
 
     void triggerGC();
 
-    std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t size);
+    // 增量式回收：推进当前这一轮GC，在约budget的时间内完成一部分标记、转移或清扫，GC尚未完成时返回true
+    bool step(std::chrono::microseconds budget);
+
+    // 当前线程嵌套在make_gc中的层数；嵌套时外层仍处于临界区，此时不能在分配时推进GC
+    static thread_local int allocation_depth;
+
+    void stepOnAllocation() {
+        if constexpr (GCParameter::enableIncrementalGC && GCParameter::incrementalStepOnAllocation) {
+            if (allocation_depth == 0 && GCPhase::duringGC())
+                step(std::chrono::microseconds(GCParameter::incrementalAllocationStepBudget));
+        }
+    }
+
+    std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t size, bool leaf = false);
 
     void registerObject(void* object_addr, size_t object_size);
 
@@ -131,6 +263,10 @@ public:
 
     void removeRoot(GCPtrBase*);
 
+    void addRootFrame(GCRootFrame*);
+
+    void removeRootFrame(GCRootFrame*);
+
     void addSATB(void* object_addr);
 
     void addSATB(const ObjectInfo&);
@@ -141,10 +277,19 @@ public:
 
     void replaceGCPtr(GCPtrBase* original, GCPtrBase* replacement);
 
-    void registerDestructor(void* object_addr, const std::function<void(void*)>&, GCRegion* = nullptr);
+    // 登记对象的类型编号，启用内存分配器时记录在对象所在region中，无需加锁
+    void registerType(void* object_addr, GCTypeRegistry::TypeId type_id, GCRegion* = nullptr);
+
+    // 未启用终结器线程时返回nullptr，此时析构函数在清扫和转移阶段直接调用
+    GCFinalizer* getFinalizer() const {
+        return finalizer.get();
+    }
 
     std::pair<void*, std::shared_ptr<GCRegion>> getHealedPointer(void*, size_t, GCRegion*) const;
 
+    // 转移阶段按引用关系深度优先转移：先转移root，再依次转移其引用的、位于待转移region中的对象，使相互引用的对象在目标region中相邻
+    void evacuateDepthFirst(const ObjectInfo& root);
+
     void printMap() const;
 
     bool destructorEnabled() const { return enableDestructorSupport; }
@@ -160,6 +305,10 @@ public:
     std::vector<GCPtrBase*> inside_gcptr_set(GCPtrBase* gcptr_addr, size_t object_size);
 
     void freeGCReservedMemory();
+
+    // 整理堆：反复进行整理式GC，转移所有未被固定的region，直至没有region因转移预留空间不足而留在原地或不再有进展，
+    // 之后将二级内存池中整块空闲的内存归还给操作系统；返回仍留在原地的region数
+    size_t compact();
 };
 
 #endif //CPPGCPTR_GCWORKER_H
@@ -6,15 +6,22 @@
 
 class GCRegion;
 
+enum class RegionEnum;
+
 class IMemoryAllocator {
 public:
     IMemoryAllocator() = default;
 
     virtual ~IMemoryAllocator() = default;
 
-    virtual std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t) = 0;
+    // leaf为true表示对象内不含GCPtr，分配到叶子region中，标记时无需扫描对象内容
+    virtual std::pair<void*, std::shared_ptr<GCRegion>> allocate(size_t, bool leaf = false) = 0;
+
+    // hot为true表示对象近期被应用线程访问过，转移到热region中，与冷对象分开存放
+    virtual std::pair<void*, std::shared_ptr<GCRegion>> relocate(size_t, bool leaf = false, bool hot = false) = 0;
 
-    virtual std::pair<void*, std::shared_ptr<GCRegion>> relocate(size_t) = 0;
+    // 为转移一段连续存活对象预留一整块连续空间，不标记其中的对象，由调用方逐个标记
+    virtual std::pair<void*, std::shared_ptr<GCRegion>> relocateRun(size_t, RegionEnum, bool leaf = false) = 0;
 
     virtual void* allocate_raw(size_t) = 0;
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#define _COMPILE_IDENTIFIER_SCAN_BENCHMARK 0
+
+#if _COMPILE_IDENTIFIER_SCAN_BENCHMARK
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cstring>
+#include "GCIdentifierScanner.h"
+#include "GCPtrBase.h"
+
+// 对比标量与各SIMD实现查找GCPtr标识头的结果与耗时
+class IdentifierScanBenchmark {
+private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024 * 1024;
+    static constexpr int SIZEOF_GCPTR = sizeof(void*) == 8 ? 72 : 44;
+    static constexpr int ROUNDS = 20;
+
+    static std::vector<size_t> collect(GCIdentifierScanner::FindFunc find, char* begin, char* last) {
+        std::vector<size_t> result;
+        for (char* p = find(begin, last); p != nullptr; p = find(p + sizeof(void*), last))
+            result.push_back(p - begin);
+        return result;
+    }
+
+public:
+    static void run() {
+        using namespace std;
+        unique_ptr<char[]> buffer(new char[BUFFER_SIZE]);
+        mt19937_64 rng(12345);
+        for (size_t i = 0; i < BUFFER_SIZE; i += sizeof(uint64_t)) {
+            uint64_t v = rng();
+            memcpy(buffer.get() + i, &v, sizeof(v));
+        }
+        // 大约每4KB放置一个标识头，模拟对象中稀疏的GCPtr成员
+        for (size_t i = sizeof(void*); i + sizeof(int) <= BUFFER_SIZE; i += (rng() % 1024 + 1) * sizeof(void*)) {
+            int head = GCPTR_IDENTIFIER_HEAD;
+            memcpy(buffer.get() + i, &head, sizeof(head));
+        }
+        char* begin = buffer.get();
+        char* last = begin + BUFFER_SIZE - SIZEOF_GCPTR;
+
+        vector<size_t> expected = collect(&GCIdentifierScanner::findNextScalar, begin, last);
+        cout << "Identifier scan benchmark: " << BUFFER_SIZE / 1024 / 1024 << "MB, " << expected.size() << " candidates" << endl;
+        using Level = GCIdentifierScanner::Level;
+        Level supported = GCIdentifierScanner::getSupportedLevel();
+        for (Level level : {Level::SCALAR, Level::SSE2, Level::AVX2, Level::AVX512}) {
+            if (level > supported) break;
+            GCIdentifierScanner::FindFunc find = GCIdentifierScanner::getFindFunc(level);
+            if (collect(find, begin, last) != expected) {
+                cerr << "Error: " << GCIdentifierScanner::getLevelName(level) << " result differs from scalar" << endl;
+                continue;
+            }
+            auto start = chrono::high_resolution_clock::now();
+            size_t count = 0;
+            for (int i = 0; i < ROUNDS; i++)
+                count += collect(find, begin, last).size();
+            auto end = chrono::high_resolution_clock::now();
+            double ms = chrono::duration<double, milli>(end - start).count() / ROUNDS;
+            cout << GCIdentifierScanner::getLevelName(level) << ": " << ms << "ms per scan, "
+                 << BUFFER_SIZE / ms / 1e6 << " GB/s" << (count == expected.size() * ROUNDS ? "" : " (mismatch)") << endl;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "LiveBytesCache.h"
+#include "GCRegion.h"
+
+LiveBytesCache::LiveBytesCache() : entries() {
+}
+
+void LiveBytesCache::evict(Entry& entry) {
+    if (entry.region != nullptr && entry.live_bytes != 0)
+        entry.region->addLiveSize(entry.live_bytes);
+    entry.region = nullptr;
+    entry.live_bytes = 0;
+}
+
+void LiveBytesCache::flush() {
+    for (Entry& entry : entries)
+        evict(entry);
+}
@@ -0,0 +1,52 @@
+#ifndef CPPGCPTR_LIVEBYTESCACHE_H
+#define CPPGCPTR_LIVEBYTESCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "GCParameter.h"
+
+class GCRegion;
+
+/* 标记线程私有的region存活字节数缓存
+ * 标记对象时只累加到本线程的缓存中，不再对region的live_size做原子加，避免多个标记线程同时标记同一个热点region时争用同一缓存行
+ * 缓存按region地址直接映射，发生冲突时将被替换项累加回其region；标记结束后由GC线程统一flush，flush后各region的live_size与直接累加时完全一致
+ */
+class LiveBytesCache {
+private:
+    static constexpr size_t CACHE_SIZE = GCParameter::liveBytesCacheSize;
+    static_assert(CACHE_SIZE > 0 && (CACHE_SIZE & (CACHE_SIZE - 1)) == 0, "LiveBytesCache: cache size must be a power of 2");
+
+    struct Entry {
+        GCRegion* region;
+        size_t live_bytes;
+    };
+
+    Entry entries[CACHE_SIZE];
+
+    static size_t indexOf(GCRegion* region) {
+        uintptr_t key = reinterpret_cast<uintptr_t>(region);
+        return (key ^ key >> 12) / alignof(std::max_align_t) & (CACHE_SIZE - 1);
+    }
+
+    void evict(Entry& entry);
+
+public:
+    LiveBytesCache();
+
+    LiveBytesCache(const LiveBytesCache&) = delete;
+
+    void add(GCRegion* region, size_t live_bytes) {
+        Entry& entry = entries[indexOf(region)];
+        if (entry.region != region) {
+            evict(entry);
+            entry.region = region;
+        }
+        entry.live_bytes += live_bytes;
+    }
+
+    // 将缓存中的存活字节数全部累加回各region并清空缓存；调用时该线程不能正在标记
+    void flush();
+};
+
+
+#endif //CPPGCPTR_LIVEBYTESCACHE_H
@@ -0,0 +1,106 @@
+#ifndef CPPGCPTR_MARKCHUNKQUEUE_H
+#define CPPGCPTR_MARKCHUNKQUEUE_H
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "ObjectInfo.h"
+
+// 对象的一个扫描块，只扫描标识头位于对象内[begin, end)偏移范围的GCPtr
+struct ScanChunk {
+    ObjectInfo object;
+    size_t begin;
+    size_t end;
+};
+
+/* 并行标记时共享的扫描块队列
+ * 超过阈值的大对象在标记后被切分为若干扫描块放入该队列，由所有标记线程共同扫描，避免单个巨型对象拖慢标记的收尾
+ * 终止检测：active_workers记录仍可能产生新扫描块的线程数，线程完成自身的任务份额后减一，取出扫描块时加一、扫描完毕后减一；
+ * 取出与判定终止在同一把锁下进行，因此队列为空且active_workers为零时不会再有新的扫描块
+ */
+class MarkChunkQueue {
+private:
+    std::vector<ScanChunk> chunks;
+    std::mutex mutex;
+    int active_workers;
+    std::atomic<bool> enabled;
+
+    bool tryPop(ScanChunk& chunk, bool& terminated) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!chunks.empty()) {
+            chunk = chunks.back();
+            chunks.pop_back();
+            active_workers++;
+            return true;
+        }
+        terminated = active_workers == 0;
+        return false;
+    }
+
+public:
+    MarkChunkQueue() : active_workers(0), enabled(false) {
+    }
+
+    MarkChunkQueue(const MarkChunkQueue&) = delete;
+
+    // 开始一轮并行标记，worker_count为参与的标记任务数，每个任务结束前都必须调用一次drain()
+    void begin(int worker_count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        chunks.clear();
+        active_workers = worker_count;
+        enabled.store(true);
+    }
+
+    void end() {
+        enabled.store(false);
+    }
+
+    // 仅在两次begin()与end()之间为true，此时放入的扫描块保证会被扫描
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void push(const ScanChunk& chunk) {
+        std::unique_lock<std::mutex> lock(mutex);
+        chunks.push_back(chunk);
+    }
+
+    // 协助标记的应用线程取出一个扫描块并扫描，不参与终止检测，但扫描期间计入active_workers，因此不会提前判定终止；返回是否取到了扫描块
+    template<typename Func>
+    bool tryHelp(Func&& scan) {
+        if (!isEnabled()) return false;
+        ScanChunk chunk;
+        bool terminated = false;
+        if (!tryPop(chunk, terminated)) return false;
+        scan(chunk);
+        std::unique_lock<std::mutex> lock(mutex);
+        active_workers--;
+        return true;
+    }
+
+    // 当前标记任务已完成自身份额，转而协助扫描队列中的扫描块，直至所有线程都无事可做
+    template<typename Func>
+    void drain(Func&& scan) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            active_workers--;
+        }
+        ScanChunk chunk;
+        while (true) {
+            bool terminated = false;
+            if (tryPop(chunk, terminated)) {
+                scan(chunk);
+                std::unique_lock<std::mutex> lock(mutex);
+                active_workers--;
+            } else if (terminated) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+
+#endif //CPPGCPTR_MARKCHUNKQUEUE_H
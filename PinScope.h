@@ -0,0 +1,84 @@
+#ifndef CPPGCPTR_PINSCOPE_H
+#define CPPGCPTR_PINSCOPE_H
+
+#include <vector>
+#include <stdexcept>
+#include "GCWorker.h"
+#include "GCRegion.h"
+
+template<typename T>
+class GCPtr;
+
+namespace gc {
+    // 在一个作用域内一次性钉住若干对象所在的region，作用域内可直接通过裸引用访问这些对象，无需每次->都构造PtrGuard
+    // 与PtrGuard相同，钉住期间region不会被重定位：启用doNotRelocatePtrGuard时选择转移集合会跳过这些region，否则转移前会等待作用域结束
+    // 同一region只会被钉住一次；PinScope应仅在栈上使用，且生命周期应覆盖所有取出的引用
+    class PinScope {
+    private:
+        static constexpr int INLINE_CAPACITY = 8;
+        GCRegion* inline_regions[INLINE_CAPACITY];
+        int inline_count;
+        std::vector<GCRegion*> overflow_regions;
+        const bool relocationEnabled;
+
+        bool pinned(GCRegion* region) const {
+            for (int i = 0; i < inline_count; i++) {
+                if (inline_regions[i] == region) return true;
+            }
+            for (GCRegion* r : overflow_regions) {
+                if (r == region) return true;
+            }
+            return false;
+        }
+
+        void pinRegion(GCRegion* region) {
+            if (!relocationEnabled || region == nullptr || pinned(region)) return;
+            region->inc_use_count();
+            if (inline_count < INLINE_CAPACITY)
+                inline_regions[inline_count++] = region;
+            else
+                overflow_regions.push_back(region);
+        }
+
+    public:
+        PinScope() : inline_count(0), relocationEnabled(GCWorker::getWorker()->relocationEnabled()) {
+        }
+
+        template<typename... Ts>
+        explicit PinScope(GCPtr<Ts>&... ptrs) : PinScope() {
+            (pin(ptrs), ...);
+        }
+
+        ~PinScope() {
+            for (int i = 0; i < inline_count; i++) {
+                inline_regions[i]->dec_use_count();
+            }
+            for (GCRegion* region : overflow_regions) {
+                region->dec_use_count();
+            }
+            inline_count = 0;
+            overflow_regions.clear();
+        }
+
+        PinScope(const PinScope&) = delete;
+
+        PinScope(PinScope&&) noexcept = delete;
+
+        PinScope& operator=(const PinScope&) = delete;
+
+        template<typename T>
+        T& pin(GCPtr<T>& ptr) {
+            T* obj = ptr.getRaw();      // 先完成指针自愈，钉住的是对象当前所在的region
+            if (obj == nullptr)
+                throw std::invalid_argument("gc::PinScope::pin(): Cannot pin a null GCPtr");
+            pinRegion(ptr.region.get());
+            return *obj;
+        }
+
+        int size() const {
+            return inline_count + static_cast<int>(overflow_regions.size());
+        }
+    };
+}
+
+#endif //CPPGCPTR_PINSCOPE_H
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// 定长的先进先出环形队列，标记时用于在真正处理对象前若干步发出预取，使访存与处理重叠
+template<typename T, int Capacity>
+class PrefetchQueue {
+    static_assert(Capacity > 0, "PrefetchQueue: Capacity must be positive");
+
+private:
+    T items[Capacity];
+    int head = 0;
+    int count = 0;
+
+public:
+    bool empty() const { return count == 0; }
+
+    bool full() const { return count == Capacity; }
+
+    void push(const T& item) {
+        int tail = head + count;
+        if (tail >= Capacity) tail -= Capacity;
+        items[tail] = item;
+        count++;
+    }
+
+    T pop() {
+        T item = items[head];
+        if (++head == Capacity) head = 0;
+        count--;
+        return item;
+    }
+};
@@ -27,6 +27,11 @@ public:
     PtrGuard(T* ptr, GCRegion* region) : PtrGuard(ptr, region, DeferGuard) {
         if (relocationEnabled)
             lock();
+        if constexpr (GCParameter::enableHotColdRelocation) {
+            // 未持有use_count时region可能随时被释放，不记录访问；未启用重分配时也无需区分冷热
+            if (relocationEnabled && region != nullptr)
+                region->sampleAccess(ptr);
+        }
     }
 
     ~PtrGuard() {
@@ -0,0 +1,88 @@
+#ifndef CPPGCPTR_ROOTFRAME_H
+#define CPPGCPTR_ROOTFRAME_H
+
+#include <cstddef>
+#include <new>
+#include "GCWorker.h"
+#include "GCThreadRootSet.h"
+#include "GCParameter.h"
+
+template<typename T>
+class GCPtr;
+
+namespace gc {
+    // 根帧：在栈上一次性持有N个GCPtr，作为一条记录登记到当前线程根集合分段的影子栈中，作用域结束时O(1)注销
+    // 其中的GCPtr本身不再逐个加入/移出根集合，GC标记根时整块扫描；适用于局部GCPtr数组或调用链较深、每层都有若干局部GCPtr的场景
+    // 未启用按线程划分的根集合时退化为逐个登记；启用保守式栈扫描时栈上的GCPtr本就无需登记
+    // RootFrame只能在栈上使用，并且须在创建它的线程上析构
+    template<typename T, size_t N>
+    class RootFrame {
+        static_assert(N > 0, "gc::RootFrame: N must be positive");
+
+    private:
+        static constexpr bool useFrame = GCParameter::useArrayAsRootSet && GCParameter::useThreadLocalRootSet
+                                         && !GCParameter::useConservativeStackScan;
+
+        alignas(GCPtr<T>) unsigned char storage[N * sizeof(GCPtr<T>)];
+        GCRootFrame frame;
+
+        GCPtr<T>* slots() {
+            return std::launder(reinterpret_cast<GCPtr<T>*>(storage));
+        }
+
+        const GCPtr<T>* slots() const {
+            return std::launder(reinterpret_cast<const GCPtr<T>*>(storage));
+        }
+
+    public:
+        RootFrame() : frame{} {
+            for (size_t i = 0; i < N; i++) {
+                if constexpr (useFrame)
+                    new (&slots()[i]) GCPtr<T>(false);
+                else
+                    new (&slots()[i]) GCPtr<T>();
+            }
+            if constexpr (useFrame) {
+                frame.base = static_cast<GCPtrBase*>(&slots()[0]);
+                frame.count = N;
+                frame.stride = sizeof(GCPtr<T>);
+                GCWorker::getWorker()->addRootFrame(&frame);
+            }
+        }
+
+        ~RootFrame() {
+            if constexpr (useFrame)
+                GCWorker::getWorker()->removeRootFrame(&frame);
+            for (size_t i = N; i > 0; i--)
+                slots()[i - 1].~GCPtr<T>();
+        }
+
+        RootFrame(const RootFrame&) = delete;
+
+        RootFrame(RootFrame&&) noexcept = delete;
+
+        RootFrame& operator=(const RootFrame&) = delete;
+
+        GCPtr<T>& operator[](size_t i) {
+            return slots()[i];
+        }
+
+        const GCPtr<T>& operator[](size_t i) const {
+            return slots()[i];
+        }
+
+        GCPtr<T>* begin() {
+            return slots();
+        }
+
+        GCPtr<T>* end() {
+            return slots() + N;
+        }
+
+        static constexpr size_t size() {
+            return N;
+        }
+    };
+}
+
+#endif //CPPGCPTR_ROOTFRAME_H
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 分条计数器：每个线程固定落在其中一条上计数，各条独占一个缓存行，避免多线程频繁增减同一个计数器造成的缓存行争用
+// 每条分别记录单调递增的inc和dec次数，判零时先汇总所有dec再汇总所有inc，若两者相等则保证存在某一时刻计数确实为零
+// 适用于写多读少的场景，如PtrGuard对region的引用计数
+template<int StripeCount>
+class StripedCounter {
+    static_assert(StripeCount > 0, "StripedCounter: StripeCount must be positive");
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Stripe {
+        std::atomic<uint64_t> inc_count{0};
+        std::atomic<uint64_t> dec_count{0};
+    };
+
+    Stripe stripes[StripeCount];
+
+    static int getStripeIdx() {
+        if constexpr (StripeCount == 1) return 0;
+        // 轮流分配而不是对线程id取哈希，线程id（如pthread_t）通常按栈大小对齐，直接取模会集中在少数几条上
+        static std::atomic<int> next_stripe_idx{0};
+        thread_local int stripe_idx_cached = next_stripe_idx.fetch_add(1, std::memory_order_relaxed) % StripeCount;
+        return stripe_idx_cached;
+    }
+
+public:
+    StripedCounter() = default;
+
+    StripedCounter(const StripedCounter&) = delete;
+
+    StripedCounter& operator=(const StripedCounter&) = delete;
+
+    void inc() {
+        stripes[getStripeIdx()].inc_count.fetch_add(1);
+    }
+
+    void dec() {
+        stripes[getStripeIdx()].dec_count.fetch_add(1);
+    }
+
+    bool isZero() const {
+        uint64_t total_dec = 0, total_inc = 0;
+        for (const Stripe& stripe : stripes)
+            total_dec += stripe.dec_count.load();
+        for (const Stripe& stripe : stripes)
+            total_inc += stripe.inc_count.load();
+        return total_inc == total_dec;
+    }
+};
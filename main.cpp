@@ -2,10 +2,13 @@
 #include <thread>
 #include <string>
 #include "GCPtr.h"
+#include "IdentifierScanBenchmark.h"
+#include "EvacuationOrderBenchmark.h"
 
 #define MULTITHREAD_TEST 1
 #define DESTRUCTOR_TEST 0
 #define WITH_STL_TEST 1
+#define COMPACT_TEST 1
 
 #if !_WIN32
 void Sleep(int millisecond) {
@@ -331,6 +334,12 @@ int main() {
     using namespace std;
     cout << "Size of MyObject: " << sizeof(MyObject) << endl;
     cout << "Size of GCPtr: " << sizeof(GCPtr<void>) << endl;
+#if _COMPILE_IDENTIFIER_SCAN_BENCHMARK
+    IdentifierScanBenchmark::run();
+#endif
+#if _COMPILE_EVACUATION_ORDER_BENCHMARK
+    EvacuationOrderBenchmark::run();
+#endif
     cout << "Ready to start..." << endl;
     const int n = 25;
     long long time_ = 0;
@@ -427,7 +436,7 @@ int main() {
         {
             srand(time(0));
             const int arr_size = 128;
-            GCPtr<MyObject> aobj[arr_size];
+            gc::RootFrame<MyObject, arr_size> aobj;
             GCPtr<vector<GCPtr<MyObject>>> gcptr_vec = gc::make_gc<vector<GCPtr<MyObject>>>();
             // gcptr_vec->reserve(100000);
             GCPtr<MyObject> obj11 = gc::make_gc<MyObject>();
@@ -455,6 +464,19 @@ int main() {
                     double _b = aobj[r]->b;
                 }
             }
+            {
+                // 在循环外一次性钉住aobj中的对象，循环内直接通过裸引用访问，不再为每次访问构造PtrGuard
+                gc::PinScope pinScope;
+                std::vector<MyObject*> pinned;
+                for (int j = 0; j < arr_size; j++) {
+                    if (aobj[j] != nullptr)
+                        pinned.push_back(&pinScope.pin(aobj[j]));
+                }
+                for (int round = 0; round < 100; round++) {
+                    for (MyObject* p : pinned)
+                        p->b += p->f;
+                }
+            }
             obj11->b = (double)obj10->a / 2;
         }
         obj10->b = obj10->d->a * 2;
@@ -487,6 +509,10 @@ int main() {
         gc::freeReservedMemory();
 #endif
     }
+#if COMPACT_TEST
+    gc::compact();
+    cout << "Heap compacted" << endl;
+#endif
 
     Sleep(1000);
     cout << "Average user thread duration: " << (double)time_ / (double)n << " ms" << endl;